@@ -0,0 +1,106 @@
+﻿// <remarks>
+// Copyright 2011 - Steve Stanton. This file is part of Backsight
+//
+// Backsight is free software; you can redistribute it and/or modify it under the terms
+// of the GNU Lesser General Public License as published by the Free Software Foundation;
+// either version 3 of the License, or (at your option) any later version.
+//
+// Backsight is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// </remarks>
+
+using Xunit;
+
+namespace Backsight.Editor.Tests;
+
+/// <summary>
+/// Checks that lines encoded by the LineStringCodec class in CEdit can be decoded.
+/// </summary>
+public class MultiSegmentGeometryTest
+{
+    /// <summary>
+    /// A line with 4 vertices (in microns), and the bytes that LineStringCodec encodes it to.
+    /// The same bytes are used by LineStringCodecTest.cpp (in CEdit\Tests), so change both
+    /// if this changes.
+    /// </summary>
+    static readonly long[] s_SampleLine = { 1000, 2000, 1063, 1936, 1064, 1872, -1000000, 5 };
+    static readonly byte[] s_SampleData = { 0x04, 0xD0, 0x0F, 0xA0, 0x1F, 0x7E, 0x7F, 0x02, 0x7F,
+                                            0xCF, 0x99, 0x7A, 0x95, 0x1D };
+
+    [Fact]
+    public void DecodesSampleLine()
+    {
+        IPointGeometry[] result = MultiSegmentGeometry.DecodeLineString(s_SampleData);
+        CheckVertices(s_SampleLine, result);
+    }
+
+    [Fact]
+    public void DecodesSingleVertex()
+    {
+        IPointGeometry[] result = MultiSegmentGeometry.DecodeLineString(new byte[] { 0x01, 0xD0, 0x0F, 0xA0, 0x1F });
+        CheckVertices(new long[] { 1000, 2000 }, result);
+    }
+
+    [Fact]
+    public void DecodesLargestDeltas()
+    {
+        // A delta of long.MinValue from the origin takes 10 bytes, with just the low bit
+        // set in the last one. The second vertex wraps back round to long.MaxValue.
+        byte[] data = { 0x02,
+                        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00,
+                        0x01, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 };
+
+        IPointGeometry[] result = MultiSegmentGeometry.DecodeLineString(data);
+        CheckVertices(new long[] { long.MinValue, 0, long.MaxValue, long.MaxValue }, result);
+    }
+
+    [Fact]
+    public void RejectsTruncatedData()
+    {
+        for (int i = 0; i < s_SampleData.Length; i++)
+        {
+            byte[] data = s_SampleData.Take(i).ToArray();
+            Assert.Throws<FormatException>(() => MultiSegmentGeometry.DecodeLineString(data));
+        }
+    }
+
+    [Fact]
+    public void RejectsExtraData()
+    {
+        byte[] data = s_SampleData.Append((byte)0).ToArray();
+        Assert.Throws<FormatException>(() => MultiSegmentGeometry.DecodeLineString(data));
+    }
+
+    [Fact]
+    public void RejectsBadVertexCount()
+    {
+        byte[] data = (byte[])s_SampleData.Clone();
+        data[0] = 7;
+        Assert.Throws<FormatException>(() => MultiSegmentGeometry.DecodeLineString(data));
+    }
+
+    [Fact]
+    public void RejectsOversizedVarint()
+    {
+        byte[] overflow = { 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x03, 0x00 };
+        Assert.Throws<FormatException>(() => MultiSegmentGeometry.DecodeLineString(overflow));
+
+        byte[] tooLong = { 0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00 };
+        Assert.Throws<FormatException>(() => MultiSegmentGeometry.DecodeLineString(tooLong));
+    }
+
+    static void CheckVertices(long[] expected, IPointGeometry[] result)
+    {
+        Assert.Equal(expected.Length / 2, result.Length);
+
+        for (int i = 0; i < result.Length; i++)
+        {
+            Assert.Equal(expected[2 * i], result[i].Easting.Microns);
+            Assert.Equal(expected[2 * i + 1], result[i].Northing.Microns);
+        }
+    }
+}
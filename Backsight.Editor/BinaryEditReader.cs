@@ -0,0 +1,449 @@
+﻿// <remarks>
+// Copyright 2011 - Steve Stanton. This file is part of Backsight
+//
+// Backsight is free software; you can redistribute it and/or modify it under the terms
+// of the GNU Lesser General Public License as published by the Free Software Foundation;
+// either version 3 of the License, or (at your option) any later version.
+//
+// Backsight is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+// without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+// </remarks>
+
+using System.Text;
+
+namespace Backsight.Editor;
+
+/// <summary>
+/// Implementation of <see cref="IEditReader"/> that loads edits written by the BinaryEditWriter
+/// class in CEdit.
+/// </summary>
+/// <remarks>
+/// The file starts with the signature "BSED", followed by a one-byte format version. Each item
+/// then starts with a one-byte tag holding its <see cref="DataField"/> value, followed by the
+/// value itself (little-endian, with the same width as the type being read). Timestamps are
+/// 64-bit time_t values. Strings are a varint holding the length plus one (0 for a null),
+/// followed by the characters. Byte arrays are a varint length, followed by the bytes. Objects
+/// are bracketed by marker bytes, and the elements of an array are tagged with a marker plus a
+/// varint index (in place of the "[n]" name tag used in text files).
+/// <para/>
+/// The width of a value is not recorded in the file, so the reader can't skip over values
+/// that the caller doesn't ask for. Calling <see cref="ReadEndObject"/> anywhere other than
+/// at the end of an object will throw a <see cref="FormatException"/>.
+/// </remarks>
+class BinaryEditReader : IEditReader
+{
+    #region Constants
+
+    /// <summary>
+    /// The bytes at the start of a binary edit file.
+    /// </summary>
+    static readonly byte[] s_Signature = { (byte)'B', (byte)'S', (byte)'E', (byte)'D' };
+
+    /// <summary>
+    /// The format version that this reader understands.
+    /// </summary>
+    const byte Version = 1;
+
+    /// <summary>
+    /// Marker bytes (these lie beyond the range of DataField values).
+    /// </summary>
+    const byte ArrayItemMarker = 0xFC;
+    const byte BeginObjectMarker = 0xFD;
+    const byte EndObjectMarker = 0xFE;
+
+    /// <summary>
+    /// The tag for each name that can be supplied to the read methods.
+    /// </summary>
+    static readonly Dictionary<string, byte> s_Tags = CreateTags();
+
+    #endregion
+
+    #region Class data
+
+    /// <summary>
+    /// The stream holding the binary data.
+    /// </summary>
+    readonly Stream m_Stream;
+
+    /// <summary>
+    /// Data that has been read from the stream, but not yet consumed.
+    /// </summary>
+    readonly byte[] m_Buffer;
+
+    /// <summary>
+    /// The index of the next unconsumed byte in <see cref="m_Buffer"/>.
+    /// </summary>
+    int m_Pos;
+
+    /// <summary>
+    /// The number of bytes currently held in <see cref="m_Buffer"/>.
+    /// </summary>
+    int m_Length;
+
+    #endregion
+
+    #region Constructors
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="BinaryEditReader"/> class
+    /// that reads from the supplied stream.
+    /// </summary>
+    /// <param name="stream">The stream holding the edits (not null). It should be positioned
+    /// at the start of the signature.</param>
+    /// <exception cref="FormatException">If the stream doesn't start with the expected
+    /// signature and version.</exception>
+    internal BinaryEditReader(Stream stream)
+    {
+        if (stream == null)
+            throw new ArgumentNullException();
+
+        m_Stream = stream;
+        m_Buffer = new byte[64 * 1024];
+        m_Pos = m_Length = 0;
+
+        foreach (byte b in s_Signature)
+        {
+            if (PeekByte() != b)
+                throw new FormatException("Stream does not hold binary edits");
+
+            m_Pos++;
+        }
+
+        byte version = NextByte();
+        if (version != Version)
+            throw new FormatException(String.Format("Unsupported binary edit version {0}", version));
+    }
+
+    #endregion
+
+    /// <summary>
+    /// Associates each <see cref="DataField"/> name with its tag value.
+    /// </summary>
+    static Dictionary<string, byte> CreateTags()
+    {
+        var result = new Dictionary<string, byte>();
+
+        foreach (DataField f in Enum.GetValues(typeof(DataField)))
+            result[f.ToString()] = (byte)f;
+
+        return result;
+    }
+
+    /// <summary>
+    /// Is more data available?
+    /// </summary>
+    public bool HasNext
+    {
+        get { return (PeekByte() >= 0); }
+    }
+
+    /// <summary>
+    /// Reads the marker that precedes the data values for an object.
+    /// </summary>
+    public void ReadBeginObject()
+    {
+        if (PeekByte() != BeginObjectMarker)
+            throw new ArgumentException("Expected the start of an object");
+
+        m_Pos++;
+    }
+
+    /// <summary>
+    /// Reads the marker that follows the data values for an object.
+    /// </summary>
+    /// <exception cref="FormatException">If the object has any values that haven't been read</exception>
+    public void ReadEndObject()
+    {
+        if (PeekByte() != EndObjectMarker)
+            throw new FormatException("Expected the end of an object (unread values can't be skipped in binary edits)");
+
+        m_Pos++;
+    }
+
+    #region IEditReader Members
+
+    /// <summary>
+    /// Reads the next byte.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The byte value that was read.</returns>
+    public byte ReadByte(string name)
+    {
+        ReadTag(name);
+        return NextByte();
+    }
+
+    /// <summary>
+    /// Reads a 4-byte signed integer.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The 4-byte value that was read.</returns>
+    public int ReadInt32(string name)
+    {
+        ReadTag(name);
+        return BitConverter.ToInt32(NextBytes(4));
+    }
+
+    /// <summary>
+    /// Reads a 4-byte unsigned integer.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The 4-byte unsigned value that was read.</returns>
+    public uint ReadUInt32(string name)
+    {
+        ReadTag(name);
+        return BitConverter.ToUInt32(NextBytes(4));
+    }
+
+    /// <summary>
+    /// Reads an 8-byte signed integer.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The 8-byte value that was read.</returns>
+    public long ReadInt64(string name)
+    {
+        ReadTag(name);
+        return BitConverter.ToInt64(NextBytes(8));
+    }
+
+    /// <summary>
+    /// Reads an eight-byte floating-point value.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The 8-byte floating-point value that was read.</returns>
+    public double ReadDouble(string name)
+    {
+        ReadTag(name);
+        return BitConverter.ToDouble(NextBytes(8));
+    }
+
+    /// <summary>
+    /// Reads a four-byte floating-point value.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The 4-byte floating-point value that was read.</returns>
+    public float ReadSingle(string name)
+    {
+        ReadTag(name);
+        return BitConverter.ToSingle(NextBytes(4));
+    }
+
+    /// <summary>
+    /// Reads a one-byte boolean value.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The boolean value that was read.</returns>
+    public bool ReadBool(string name)
+    {
+        ReadTag(name);
+        return (NextByte() != 0);
+    }
+
+    /// <summary>
+    /// Reads a string.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value (or "[n]" for the type name
+    /// of an array element)</param>
+    /// <returns>The string that was read (null if the string was null or empty, the same as
+    /// with <see cref="TextEditReader"/>)</returns>
+    public string ReadString(string name)
+    {
+        if (name.StartsWith("["))
+            ReadArrayItem(name);
+        else
+            ReadTag(name);
+
+        ulong len = ReadVarint();
+        if (len <= 1)
+            return null;
+
+        return Encoding.Default.GetString(NextBytes(checked((int)(len - 1))));
+    }
+
+    /// <summary>
+    /// Reads a timestamp.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The timestamp that was read (in local time).</returns>
+    public DateTime ReadDateTime(string name)
+    {
+        ReadTag(name);
+        long t = BitConverter.ToInt64(NextBytes(8));
+        return DateTimeOffset.FromUnixTimeSeconds(t).LocalDateTime;
+    }
+
+    /// <summary>
+    /// Reads an internal ID.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The ID that was read.</returns>
+    public InternalIdValue ReadInternalId(string name)
+    {
+        return new InternalIdValue(ReadUInt32(name));
+    }
+
+    /// <summary>
+    /// Reads an array of bytes.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The bytes that were read.</returns>
+    public byte[] ReadBytes(string name)
+    {
+        ReadTag(name);
+        ulong len = ReadVarint();
+        return NextBytes(checked((int)len)).ToArray();
+    }
+
+    /// <summary>
+    /// Checks whether the next data item has a specific name tag. Make a call to any
+    /// <c>Read</c> method to actually advance.
+    /// </summary>
+    /// <param name="name">The name tag to check for</param>
+    /// <returns>True if the next data item has the specified name tag</returns>
+    public bool IsNextField(string name)
+    {
+        int b = PeekByte();
+        if (b < 0)
+            return false;
+
+        if (name.StartsWith("["))
+            return (b == ArrayItemMarker);
+
+        byte tag;
+        return (s_Tags.TryGetValue(name, out tag) && b == tag);
+    }
+
+    #endregion
+
+    /// <summary>
+    /// Reads the tag at the start of an item, and confirms that it's the expected one.
+    /// </summary>
+    /// <param name="name">The name of the expected field</param>
+    /// <exception cref="ArgumentException">If the next item has some other tag</exception>
+    void ReadTag(string name)
+    {
+        byte tag;
+        if (!s_Tags.TryGetValue(name, out tag))
+            throw new ArgumentException("Unknown field name: " + name);
+
+        int b = PeekByte();
+        if (b != tag)
+            throw new ArgumentException(String.Format("Expected '{0}' but found tag {1}", name, b));
+
+        m_Pos++;
+    }
+
+    /// <summary>
+    /// Reads the marker and index that precede the type name for an array element.
+    /// </summary>
+    /// <param name="name">The expected name, in the form "[n]"</param>
+    /// <exception cref="ArgumentException">If the next item isn't the expected element</exception>
+    void ReadArrayItem(string name)
+    {
+        if (PeekByte() != ArrayItemMarker)
+            throw new ArgumentException(String.Format("Expected '{0}'", name));
+
+        m_Pos++;
+        ulong index = ReadVarint();
+
+        if (name != String.Format("[{0}]", index))
+            throw new ArgumentException(String.Format("Expected '{0}' but found [{1}]", name, index));
+    }
+
+    /// <summary>
+    /// Reads a value that was written using 7 bits per byte (least significant group first).
+    /// </summary>
+    ulong ReadVarint()
+    {
+        ulong value = 0;
+
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            byte b = NextByte();
+            value |= ((ulong)(b & 0x7F) << shift);
+
+            if ((b & 0x80) == 0)
+                return value;
+        }
+
+        throw new FormatException("Varint is too long");
+    }
+
+    /// <summary>
+    /// The next byte, without consuming it (-1 at the end of the stream).
+    /// </summary>
+    int PeekByte()
+    {
+        if (m_Pos == m_Length && !Fill(1))
+            return -1;
+
+        return m_Buffer[m_Pos];
+    }
+
+    /// <summary>
+    /// Consumes the next byte.
+    /// </summary>
+    /// <exception cref="EndOfStreamException">If there is no more data</exception>
+    byte NextByte()
+    {
+        if (m_Pos == m_Length && !Fill(1))
+            throw new EndOfStreamException();
+
+        return m_Buffer[m_Pos++];
+    }
+
+    /// <summary>
+    /// Consumes the next few bytes.
+    /// </summary>
+    /// <param name="n">The number of bytes to consume</param>
+    /// <returns>The consumed bytes (only valid until the next read)</returns>
+    /// <exception cref="EndOfStreamException">If there isn't enough data</exception>
+    ReadOnlySpan<byte> NextBytes(int n)
+    {
+        // Anything bigger than the buffer gets read directly
+        if (n > m_Buffer.Length)
+        {
+            byte[] result = new byte[n];
+            int nHave = m_Length - m_Pos;
+            Array.Copy(m_Buffer, m_Pos, result, 0, nHave);
+            m_Pos = m_Length;
+            m_Stream.ReadExactly(result, nHave, n - nHave);
+            return result;
+        }
+
+        if (m_Length - m_Pos < n && !Fill(n))
+            throw new EndOfStreamException();
+
+        var span = new ReadOnlySpan<byte>(m_Buffer, m_Pos, n);
+        m_Pos += n;
+        return span;
+    }
+
+    /// <summary>
+    /// Reads more data, so that at least n bytes are available.
+    /// </summary>
+    /// <returns>False if the end of the stream was reached first.</returns>
+    bool Fill(int n)
+    {
+        // Shift down anything that's still unread
+        int nHave = m_Length - m_Pos;
+        Array.Copy(m_Buffer, m_Pos, m_Buffer, 0, nHave);
+        m_Pos = 0;
+        m_Length = nHave;
+
+        while (m_Length < n)
+        {
+            int nRead = m_Stream.Read(m_Buffer, m_Length, m_Buffer.Length - m_Length);
+            if (nRead == 0)
+                return false;
+
+            m_Length += nRead;
+        }
+
+        return true;
+    }
+}
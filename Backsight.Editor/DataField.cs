@@ -22,8 +22,9 @@ namespace Backsight.Editor;
 /// </summary>
 /// <remarks>
 /// These values are used to help avoid potential typos that might not get caught until
-/// run-time. As things currently stand, these values do not get persisted, so you can
-/// re-arrange them as you please. This may need to change if a binary writer is provided.</remarks>
+/// run-time. The values get persisted as tags in binary edit files (see <see cref="BinaryEditReader"/>),
+/// and must match the DataField enum in CEdit, so do NOT re-arrange them (append any new values
+/// to the end).</remarks>
 internal enum DataField : ushort
 {
     Empty = 0,
@@ -813,6 +813,16 @@ class EditDeserializer
         return m_Reader.ReadInternalId(field.ToString());
     }
 
+    /// <summary>
+    /// Reads an array of bytes.
+    /// </summary>
+    /// <param name="field">A tag associated with the value</param>
+    /// <returns>The bytes that were read</returns>
+    internal byte[] ReadBytes(DataField field)
+    {
+        return m_Reader.ReadBytes(field.ToString());
+    }
+
     /// <summary>
     /// Checks whether the next data item has a specific field tag. Make a call to any
     /// <c>Read</c> method to actually advance.
@@ -20,10 +20,15 @@ namespace Backsight.Editor;
 /// Methods that may be used to load the description of edits (previously written using
 /// an implementation of <see cref="IEditWriter"/>).
 /// <para/>
-/// Implemented by <see cref="TextEditReader"/>.
+/// Implemented by <see cref="TextEditReader"/> and <see cref="BinaryEditReader"/>.
 /// </summary>
 interface IEditReader
 {
+    /// <summary>
+    /// Is more data available?
+    /// </summary>
+    bool HasNext { get; }
+
     /// <summary>
     /// Reads the next byte.
     /// </summary>
@@ -94,6 +99,13 @@ interface IEditReader
     /// <returns>The ID that was read.</returns>
     InternalIdValue ReadInternalId(string name);
 
+    /// <summary>
+    /// Reads an array of bytes.
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The bytes that were read.</returns>
+    byte[] ReadBytes(string name);
+
     /// <summary>
     /// Reads any text that precedes the data values for an object.
     /// </summary>
@@ -77,6 +77,15 @@ class MultiSegmentGeometry : UnsectionedLineGeometry, IMultiSegmentGeometry
     internal MultiSegmentGeometry(EditDeserializer editDeserializer)
         : base(editDeserializer)
     {
+        // Lines exported by CEdit may hold the vertices as delta-encoded bytes
+        if (editDeserializer.IsNextField(DataField.Data))
+        {
+            byte[] data = editDeserializer.ReadBytes(DataField.Data);
+            m_Data = DecodeLineString(data);
+            m_Extent = LineStringGeometry.GetExtent(this);
+            return;
+        }
+
         // LineString assumes 2D, with X preceding Y. Each coordinate pair is separated
         // with a comma, with a space between each X and Y (e.g. "123 345,124 349,129 341")
 
@@ -102,6 +111,69 @@ class MultiSegmentGeometry : UnsectionedLineGeometry, IMultiSegmentGeometry
 
     #endregion
 
+    /// <summary>
+    /// Decodes the vertices of a line that were packed by the LineStringCodec class in CEdit.
+    /// The data starts with the number of vertices, followed by the change in X and Y (in
+    /// microns) from one vertex to the next. Each value is a zigzag encoded varint.
+    /// </summary>
+    /// <param name="data">The encoded vertices</param>
+    /// <returns>The decoded vertices</returns>
+    /// <exception cref="FormatException">If the data is not properly formed</exception>
+    internal static IPointGeometry[] DecodeLineString(byte[] data)
+    {
+        int pos = 0;
+        ulong count = ReadVarint(data, ref pos);
+        if (count > (ulong)(data.Length - pos) / 2)
+            throw new FormatException("Bad vertex count for encoded line");
+
+        var result = new IPointGeometry[count];
+        long x = 0;
+        long y = 0;
+
+        for (int i = 0; i < result.Length; i++)
+        {
+            x = unchecked(x + UnZigZag(ReadVarint(data, ref pos)));
+            y = unchecked(y + UnZigZag(ReadVarint(data, ref pos)));
+            result[i] = new PointGeometry(x, y);
+        }
+
+        if (pos != data.Length)
+            throw new FormatException("Unexpected data after encoded line");
+
+        return result;
+    }
+
+    /// <summary>
+    /// Reads a value that was written using 7 bits per byte (least significant group first).
+    /// </summary>
+    static ulong ReadVarint(byte[] data, ref int pos)
+    {
+        ulong value = 0;
+
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (pos >= data.Length)
+                throw new FormatException("Encoded line is truncated");
+
+            // The tenth byte only has room for the top bit
+            byte b = data[pos++];
+            if (shift == 63 && b > 1)
+                throw new FormatException("Varint is too big");
+
+            value |= ((ulong)(b & 0x7F) << shift);
+
+            if ((b & 0x80) == 0)
+                return value;
+        }
+
+        throw new FormatException("Varint is too long");
+    }
+
+    static long UnZigZag(ulong value)
+    {
+        return (long)(value >> 1) ^ -(long)(value & 1);
+    }
+
     public override ILength Distance(IPosition point)
     {
         return LineStringGeometry.GetDistance(this, point);
@@ -100,7 +100,8 @@ class Project
     /// Obtains the number of the data files in the project data folder.
     /// </summary>
     /// <param name="dataFolder">The folder containing the data files</param>
-    /// <returns>The data file numbers (sorted). An empty array if the project data folder does not exist.</returns>
+    /// <returns>The data file numbers (sorted, with no duplicates). An empty array if the project data
+    /// folder does not exist.</returns>
     uint[] GetFileNumbers(string dataFolder)
     {
         if (!Directory.Exists(dataFolder))
@@ -110,15 +111,23 @@ class Project
 
         foreach (string s in Directory.GetFiles(dataFolder))
         {
-            string name = Path.GetFileNameWithoutExtension(s);
             uint n;
-            //if (name.Length == 8 && UInt32.TryParse(name, NumberStyles.HexNumber, null, out n))
-            if (UInt32.TryParse(name, out n))
+            if (ProjectDatabase.IsDataFileName(s, true, out n))
                 result.Add(n);
         }
 
         // There's a good chance the files will already be sorted, but just in case
         result.Sort();
+
+        // A file may be there in both text and binary form (it only gets loaded once)
+        int numUnique = 0;
+        for (int i = 0; i < result.Count; i++)
+        {
+            if (numUnique == 0 || result[i] != result[numUnique - 1])
+                result[numUnique++] = result[i];
+        }
+
+        result.RemoveRange(numUnique, result.Count - numUnique);
         return result.ToArray();
     }
 
@@ -223,9 +232,25 @@ class Project
         {
             string editFile = Path.Combine(folderName, ProjectDatabase.GetDataFileName(fileNum));
 
-            using (TextReader tr = File.OpenText(editFile))
+            // Files exported from CEdit may hold the edits in binary form
+            bool isBinary = false;
+            if (!File.Exists(editFile))
+            {
+                string binaryFile = Path.Combine(folderName, ProjectDatabase.GetBinaryDataFileName(fileNum));
+                if (File.Exists(binaryFile))
+                {
+                    editFile = binaryFile;
+                    isBinary = true;
+                }
+            }
+
+            using (Stream fs = File.OpenRead(editFile))
             {
-                TextEditReader er = new TextEditReader(tr);
+                IEditReader er;
+                if (isBinary)
+                    er = new BinaryEditReader(fs);
+                else
+                    er = new TextEditReader(new StreamReader(fs));
 
                 // Ignore any empty files altogether
                 while (er.HasNext)
@@ -190,6 +190,43 @@ class ProjectDatabase
         return String.Format("{0}.txt", fileNumber);
     }
 
+    /// <summary>
+    /// Obtains the name of the binary data file that corresponds to a file number (files
+    /// exported from CEdit may be written in binary form, see <see cref="BinaryEditReader"/>).
+    /// </summary>
+    /// <param name="fileNumber">The file number</param>
+    /// <returns>The corresponding file name (without any directory specification).</returns>
+    internal static string GetBinaryDataFileName(uint fileNumber)
+    {
+        return String.Format("{0}.bin", fileNumber);
+    }
+
+    /// <summary>
+    /// Checks whether a file is a data file. Other files in the data folder may also be named
+    /// after a number (e.g. a CEdit export writes its report as export-<i>N</i>.json), so the
+    /// whole name has to match.
+    /// </summary>
+    /// <param name="fileName">The name of the file (with or without a directory specification)</param>
+    /// <param name="isBinaryAllowed">Should binary data files be accepted (see <see cref="GetBinaryDataFileName"/>)?</param>
+    /// <param name="fileNumber">The file number of the data file (0 if it's not a data file)</param>
+    /// <returns>True if the file is a data file</returns>
+    internal static bool IsDataFileName(string fileName, bool isBinaryAllowed, out uint fileNumber)
+    {
+        string name = Path.GetFileName(fileName);
+
+        if (UInt32.TryParse(Path.GetFileNameWithoutExtension(name), out fileNumber))
+        {
+            if (String.Equals(name, GetDataFileName(fileNumber), StringComparison.OrdinalIgnoreCase))
+                return true;
+
+            if (isBinaryAllowed && String.Equals(name, GetBinaryDataFileName(fileNumber), StringComparison.OrdinalIgnoreCase))
+                return true;
+        }
+
+        fileNumber = 0;
+        return false;
+    }
+
     /// <summary>
     /// Attempts to load local settings for a specific project.
     /// </summary>
@@ -274,12 +274,11 @@ class Session
     {
         List<uint> result = new List<uint>(100);
 
+        // Only text files get combined (binary data files are only ever written by a CEdit export)
         foreach (string s in Directory.GetFiles(folderName))
         {
-            string name = Path.GetFileNameWithoutExtension(s);
             uint n;
-            //if (name.Length == 8 && UInt32.TryParse(name, NumberStyles.HexNumber, null, out n) && n >= startFileNumber)
-            if (UInt32.TryParse(name, out n) && n >= startFileNumber)
+            if (ProjectDatabase.IsDataFileName(s, false, out n) && n >= startFileNumber)
                 result.Add(n);
         }
 
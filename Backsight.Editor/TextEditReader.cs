@@ -163,7 +163,7 @@ class TextEditReader : IEditReader
     /// <summary>
     /// Is more data available?
     /// </summary>
-    internal bool HasNext
+    public bool HasNext
     {
         get { return (m_NextLine != null); }
     }
@@ -297,6 +297,17 @@ class TextEditReader : IEditReader
         return new InternalIdValue(s);
     }
 
+    /// <summary>
+    /// Reads an array of bytes (held in the text as base64).
+    /// </summary>
+    /// <param name="name">A name tag associated with the value</param>
+    /// <returns>The bytes that were read.</returns>
+    public byte[] ReadBytes(string name)
+    {
+        string s = ReadValue(name);
+        return (s == null ? new byte[0] : Convert.FromBase64String(s));
+    }
+
     /// <summary>
     /// Checks whether the next line of text refers to a specific name tag. Make a call to
     /// <see cref="ReadNextLine"/> to actually advance.
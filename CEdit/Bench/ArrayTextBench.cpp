@@ -0,0 +1,223 @@
+#include "StdAfx.h"
+#include "NumberFormatter.h"
+#include "Bench.h"
+
+// Measures how quickly EditSerializer turns line vertices and simple arrays into text.
+// The "before" figures come from copies of the way EditSerializer used to do it (a CString
+// that grew one value at a time, with sprintf or CString::Format for each value). The
+// "after" figures use the NumberFormatter methods that EditSerializer now calls, with a
+// buffer that is reused from one call to the next (like EditSerializer's scratch buffer).
+
+namespace
+{
+	// The old EditSerializer::WriteLineString (text form)
+	CString OldLineString(const double* xy, unsigned int numVertex)
+	{
+		CString result;
+
+		for (unsigned int i=0; i<numVertex; i++)
+		{
+			CString v;
+			if (i == 0)
+				v.Format("%lf %lf", xy[2*i], xy[2*i+1]);
+			else
+				v.Format(",%lf %lf", xy[2*i], xy[2*i+1]);
+
+			result += v;
+		}
+
+		return result;
+	}
+
+	// The old EditSerializer::WriteSimpleArray
+	CString OldSimpleArray(const CUIntArray& a)
+	{
+		CString result;
+		char buf[16];
+
+		for (int i=0; i<a.GetSize(); i++)
+		{
+			unsigned int val = a.GetAt(i);
+			if (i > 0)
+				result += ";";
+
+			sprintf(buf, "%d", val);
+			result += buf;
+		}
+
+		return result;
+	}
+
+	// A buffer that grows as needed (as for EditSerializer::GetScratch)
+	class Scratch
+	{
+	public:
+		Scratch() : m_Data(0), m_Size(0) {}
+		~Scratch() { delete [] m_Data; }
+
+		char* Get(unsigned int size)
+		{
+			if (size > m_Size)
+			{
+				delete [] m_Data;
+				m_Size = max(size, 2 * m_Size);
+				m_Data = new char[m_Size];
+			}
+
+			return m_Data;
+		}
+
+	private:
+		char* m_Data;
+		unsigned int m_Size;
+	};
+
+	// Vertices for a line that wanders about, in meters (with micron precision, as for
+	// positions that come from PointGeometry_c)
+	void MakeLine(double* xy, unsigned int numVertex, unsigned int& seed)
+	{
+		__int64 x = 500000000000LL;
+		__int64 y = 5400000000000LL;
+
+		for (unsigned int i=0; i<numVertex; i++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			x += (__int64)(seed >> 12) - (1 << 19);
+			seed = seed * 1664525 + 1013904223;
+			y += (__int64)(seed >> 12) - (1 << 19);
+
+			xy[2*i] = (double)x / 1000000.0;
+			xy[2*i+1] = (double)y / 1000000.0;
+		}
+	}
+
+	// Times writing the same lines both ways, with numLine lines of numVertex vertices
+	void BenchLines(unsigned int numLine, unsigned int numVertex)
+	{
+		double** lines = new double*[numLine];
+		unsigned int seed = 1;
+
+		for (unsigned int i=0; i<numLine; i++)
+		{
+			lines[i] = new double[2 * numVertex];
+			MakeLine(lines[i], numVertex, seed);
+		}
+
+		char name[64];
+		unsigned __int64 numBytes = 0;
+		BenchTimer timer;
+
+		for (unsigned int i=0; i<numLine; i++)
+		{
+			CString s = OldLineString(lines[i], numVertex);
+			numBytes += s.GetLength();
+		}
+
+		sprintf(name, "lines (%u vertices) before", numVertex);
+		ReportRate(name, numBytes, timer.GetSeconds());
+
+		Scratch scratch;
+		numBytes = 0;
+		timer.Restart();
+
+		for (unsigned int i=0; i<numLine; i++)
+		{
+			char* s = scratch.Get(NumberFormatter::GetMaxLineStringLength(lines[i], numVertex) + 1);
+			unsigned int len = NumberFormatter::FormatLineString(s, lines[i], numVertex);
+			s[len] = '\0';
+			numBytes += len;
+		}
+
+		sprintf(name, "lines (%u vertices) after", numVertex);
+		ReportRate(name, numBytes, timer.GetSeconds());
+
+		// Both ways should come out the same
+		for (unsigned int i=0; i<numLine; i++)
+		{
+			char* s = scratch.Get(NumberFormatter::GetMaxLineStringLength(lines[i], numVertex) + 1);
+			s[NumberFormatter::FormatLineString(s, lines[i], numVertex)] = '\0';
+
+			if (strcmp(s, (LPCTSTR)OldLineString(lines[i], numVertex)) != 0)
+			{
+				printf("*** line %u differs\n", i);
+				break;
+			}
+		}
+
+		for (unsigned int i=0; i<numLine; i++)
+			delete [] lines[i];
+
+		delete [] lines;
+	}
+
+	// Times writing the same arrays both ways, with numArray arrays of numValue values
+	void BenchArrays(unsigned int numArray, unsigned int numValue)
+	{
+		// IDs of the sort that get written as simple arrays, with the odd one that's too
+		// big for an int
+		CUIntArray* arrays = new CUIntArray[numArray];
+		unsigned int seed = 1;
+
+		for (unsigned int i=0; i<numArray; i++)
+		{
+			for (unsigned int j=0; j<numValue; j++)
+			{
+				seed = seed * 1664525 + 1013904223;
+				arrays[i].Add(seed % 1000 == 0 ? seed : (seed >> 12));
+			}
+		}
+
+		char name[64];
+		unsigned __int64 numBytes = 0;
+		BenchTimer timer;
+
+		for (unsigned int i=0; i<numArray; i++)
+		{
+			CString s = OldSimpleArray(arrays[i]);
+			numBytes += s.GetLength();
+		}
+
+		sprintf(name, "arrays (%u values) before", numValue);
+		ReportRate(name, numBytes, timer.GetSeconds());
+
+		Scratch scratch;
+		numBytes = 0;
+		timer.Restart();
+
+		for (unsigned int i=0; i<numArray; i++)
+		{
+			char* s = scratch.Get(12 * numValue + 1);
+			unsigned int len = NumberFormatter::FormatList(s, arrays[i].GetData(), numValue);
+			s[len] = '\0';
+			numBytes += len;
+		}
+
+		sprintf(name, "arrays (%u values) after", numValue);
+		ReportRate(name, numBytes, timer.GetSeconds());
+
+		for (unsigned int i=0; i<numArray; i++)
+		{
+			char* s = scratch.Get(12 * numValue + 1);
+			s[NumberFormatter::FormatList(s, arrays[i].GetData(), numValue)] = '\0';
+
+			if (strcmp(s, (LPCTSTR)OldSimpleArray(arrays[i])) != 0)
+			{
+				printf("*** array %u differs\n", i);
+				break;
+			}
+		}
+
+		delete [] arrays;
+	}
+}
+
+void BenchArrayText()
+{
+	// Lots of short lines, some longer ones, and a few that are very long
+	BenchLines(100000, 5);
+	BenchLines(10000, 100);
+	BenchLines(10, 100000);
+
+	BenchArrays(100000, 10);
+	BenchArrays(1000, 1000);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Timing helpers shared by the CEdit benchmarks. Each benchmark prints one line per
+// measurement, so that the output can be compared from one build to the next.
+class BenchTimer
+{
+public:
+	BenchTimer()
+	{
+		LARGE_INTEGER f;
+		QueryPerformanceFrequency(&f);
+		m_Frequency = f.QuadPart;
+		Restart();
+	}
+
+	void Restart()
+	{
+		LARGE_INTEGER t;
+		QueryPerformanceCounter(&t);
+		m_Start = t.QuadPart;
+	}
+
+	// The time since the timer was constructed (or last restarted)
+	double GetSeconds() const
+	{
+		LARGE_INTEGER t;
+		QueryPerformanceCounter(&t);
+		return (double)(t.QuadPart - m_Start) / (double)m_Frequency;
+	}
+
+private:
+	__int64 m_Frequency;
+	__int64 m_Start;
+};
+
+// Prints a throughput, in MB/s
+void ReportRate(LPCTSTR name, unsigned __int64 numBytes, double seconds);
+
+// Prints the time taken per item, in nanoseconds
+void ReportTime(LPCTSTR name, unsigned int numItems, double seconds);
+
+// Prints an amount of memory, in MB
+void ReportMemory(LPCTSTR name, unsigned __int64 numBytes);
+
+// The memory that has been committed by the process, in bytes
+unsigned __int64 GetPrivateBytes();
+
+// The benchmarks (see BenchMain.cpp for the names used to pick them on the command line)
+void BenchTextWriter();
+void BenchPtrIdTable();
+void BenchLocationIndex();
+void BenchArrayText();
@@ -0,0 +1,89 @@
+#include "StdAfx.h"
+#include <psapi.h>
+#include "Bench.h"
+
+#pragma comment(lib, "psapi.lib")
+
+// Runs the CEdit benchmarks. With no arguments, everything gets run, otherwise just the
+// benchmarks named on the command line (e.g. "CEditBench text").
+
+struct Benchmark
+{
+	LPCTSTR Name;
+	void (*Run)();
+};
+
+static const Benchmark Benchmarks[] =
+{
+	{ "text", BenchTextWriter },
+	{ "ptridtable", BenchPtrIdTable },
+	{ "location", BenchLocationIndex },
+	{ "arrays", BenchArrayText },
+};
+
+static const unsigned int NumBenchmark = sizeof(Benchmarks) / sizeof(Benchmarks[0]);
+
+void ReportRate(LPCTSTR name, unsigned __int64 numBytes, double seconds)
+{
+	printf("%-40s %10.1f MB/s  (%I64u bytes in %.3f s)\n", name,
+		(double)numBytes / (1024.0 * 1024.0) / seconds, numBytes, seconds);
+}
+
+void ReportTime(LPCTSTR name, unsigned int numItems, double seconds)
+{
+	printf("%-40s %10.1f ns/item  (%u items in %.3f s)\n", name,
+		seconds * 1.0e9 / (double)numItems, numItems, seconds);
+}
+
+void ReportMemory(LPCTSTR name, unsigned __int64 numBytes)
+{
+	printf("%-40s %10.1f MB\n", name, (double)numBytes / (1024.0 * 1024.0));
+}
+
+unsigned __int64 GetPrivateBytes()
+{
+	PROCESS_MEMORY_COUNTERS pmc;
+	pmc.cb = sizeof(pmc);
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return (unsigned __int64)pmc.PagefileUsage;
+
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0))
+	{
+		printf("MFC failed to initialize\n");
+		return 1;
+	}
+
+	int nRun = 0;
+
+	for (unsigned int i=0; i<NumBenchmark; i++)
+	{
+		bool run = (argc < 2);
+		for (int j=1; j<argc && !run; j++)
+			run = (_stricmp(argv[j], Benchmarks[i].Name) == 0);
+
+		if (run)
+		{
+			printf("[%s]\n", Benchmarks[i].Name);
+			Benchmarks[i].Run();
+			printf("\n");
+			nRun++;
+		}
+	}
+
+	if (nRun == 0)
+	{
+		printf("Unknown benchmark. Choose from:");
+		for (unsigned int i=0; i<NumBenchmark; i++)
+			printf(" %s", Benchmarks[i].Name);
+		printf("\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,99 @@
+#include "StdAfx.h"
+#include "CeTile.h"
+#include "CeTileId.h"
+#include "CeTileData.h"
+#include "CeLocation.h"
+#include "LocationIndex.h"
+#include "Bench.h"
+
+// Times the lookup of coincident locations through LocationIndex, against a linear scan
+// of the tile (which is what the exporter used to do for every location). This uses the
+// stand-in CEdit classes from the Tests\Fakes folder. Each tile holds locations scattered
+// over a square kilometer, with 1 in 5 of them repeated at the same position.
+
+static const unsigned int NumTile = 100;
+static const unsigned int NumLocPerTile = 10000;
+
+// The number of lookups to time for the linear scan (it's too slow to do them all)
+static const unsigned int NumScan = 2000;
+
+// A small random number generator, so that every run uses the same positions
+static unsigned int NextRandom(unsigned int& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+void BenchLocationIndex()
+{
+	CeTile* tiles = new CeTile[NumTile];
+	const unsigned int numLoc = NumTile * NumLocPerTile;
+	CeLocation** locs = new CeLocation*[numLoc];
+	unsigned int seed = 1;
+
+	__int64 e = 0;
+	__int64 n = 0;
+
+	for (unsigned int i=0; i<numLoc; i++)
+	{
+		// Every 5th location is at the same position as the one before
+		if (i % 5 != 4)
+		{
+			e = (__int64)(NextRandom(seed) % 1000000) * 1000;
+			n = (__int64)(NextRandom(seed) % 1000000) * 1000;
+		}
+
+		CeTile* t = &tiles[i / NumLocPerTile];
+		locs[i] = new CeLocation(e, n, t);
+		t->AddLocation(locs[i]);
+	}
+
+	char name[64];
+	unsigned int nFound = 0;
+	BenchTimer timer;
+	{
+		LocationIndex index;
+		CPtrArray found;
+
+		for (unsigned int i=0; i<numLoc; i++)
+		{
+			found.RemoveAll();
+			index.GetCoincidentLocations(locs[i], found);
+			nFound += (unsigned int)found.GetSize();
+		}
+	}
+
+	sprintf(name, "LocationIndex (%u found)", nFound);
+	ReportTime(name, numLoc, timer.GetSeconds());
+
+	// Scan every location in the tile, the same way LocationIndex indexes it
+	timer.Restart();
+	nFound = 0;
+
+	for (unsigned int i=0; i<NumScan; i++)
+	{
+		const CeLocation* loc = locs[(i * 7919) % numLoc];
+		const CeTile* t = loc->GetTileID().GetpTile();
+
+		for (const CeTileData* td = t->GetpTileData()->GetpTail(); td; td = td->GetpPrev())
+		{
+			unsigned int nLoc = td->GetNumLoc();
+			const CeLocation** tLocs = td->GetpLocations();
+
+			for (unsigned int j=0; j<nLoc; j++)
+			{
+				if (*loc == *tLocs[j])
+					nFound++;
+			}
+		}
+	}
+
+	sprintf(name, "Linear scan of tile (%u found)", nFound);
+	ReportTime(name, NumScan, timer.GetSeconds());
+
+	for (unsigned int i=0; i<numLoc; i++)
+		delete locs[i];
+
+	delete [] locs;
+	delete [] tiles;
+}
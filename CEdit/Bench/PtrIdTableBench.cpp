@@ -0,0 +1,119 @@
+#include "StdAfx.h"
+#include "PtrIdTable.h"
+#include "Bench.h"
+
+// Compares PtrIdTable with CMapPtrToPtr (which IdFactory used to use) for tables of 1, 5
+// and 20 million entries. The keys look like heap addresses (16-byte aligned, ascending in
+// uneven steps), and get looked up in random order. Misses use addresses that are never keys.
+// CMapPtrToPtr gets InitHashTable with a suitable size (IdFactory used the default of 17
+// buckets, which is far too slow to measure at these sizes).
+
+// A small random number generator, so that every run uses the same keys
+static unsigned int NextRandom(unsigned int& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+static void** MakeKeys(unsigned int n)
+{
+	void** keys = new void*[n];
+	size_t addr = 0x01000000;
+	unsigned int seed = 1;
+
+	for (unsigned int i=0; i<n; i++)
+	{
+		keys[i] = (void*)addr;
+		addr += 32 + (NextRandom(seed) % 4) * 16;
+	}
+
+	// Shuffle the keys, so they don't get looked up in the order they were added
+	for (unsigned int i=n-1; i>0; i--)
+	{
+		unsigned int j = NextRandom(seed) % (i+1);
+		void* t = keys[i];
+		keys[i] = keys[j];
+		keys[j] = t;
+	}
+
+	return keys;
+}
+
+static void BenchTable(unsigned int n, void** keys)
+{
+	char name[64];
+	BenchTimer timer;
+	unsigned __int64 mem = GetPrivateBytes();
+	{
+		PtrIdTable t;
+		for (unsigned int i=0; i<n; i++)
+			t.SetAt(keys[i], i+1);
+
+		sprintf(name, "PtrIdTable %uM insert", n / 1000000);
+		ReportTime(name, n, timer.GetSeconds());
+
+		sprintf(name, "PtrIdTable %uM memory", n / 1000000);
+		ReportMemory(name, GetPrivateBytes() - mem);
+
+		timer.Restart();
+		unsigned int nFound = 0;
+		unsigned int value;
+		for (unsigned int i=0; i<n; i++)
+			nFound += t.Lookup(keys[n-1-i], value);
+
+		sprintf(name, "PtrIdTable %uM hit (%u found)", n / 1000000, nFound);
+		ReportTime(name, n, timer.GetSeconds());
+
+		timer.Restart();
+		nFound = 0;
+		for (unsigned int i=0; i<n; i++)
+			nFound += t.Lookup((char*)keys[i] + 8, value);
+
+		sprintf(name, "PtrIdTable %uM miss (%u found)", n / 1000000, nFound);
+		ReportTime(name, n, timer.GetSeconds());
+	}
+
+	timer.Restart();
+	mem = GetPrivateBytes();
+	{
+		CMapPtrToPtr m;
+		m.InitHashTable(n + n/5 + 1);
+		for (unsigned int i=0; i<n; i++)
+			m.SetAt(keys[i], (void*)(size_t)(i+1));
+
+		sprintf(name, "CMapPtrToPtr %uM insert", n / 1000000);
+		ReportTime(name, n, timer.GetSeconds());
+
+		sprintf(name, "CMapPtrToPtr %uM memory", n / 1000000);
+		ReportMemory(name, GetPrivateBytes() - mem);
+
+		timer.Restart();
+		unsigned int nFound = 0;
+		void* value;
+		for (unsigned int i=0; i<n; i++)
+			nFound += (m.Lookup(keys[n-1-i], value) ? 1 : 0);
+
+		sprintf(name, "CMapPtrToPtr %uM hit (%u found)", n / 1000000, nFound);
+		ReportTime(name, n, timer.GetSeconds());
+
+		timer.Restart();
+		nFound = 0;
+		for (unsigned int i=0; i<n; i++)
+			nFound += (m.Lookup((char*)keys[i] + 8, value) ? 1 : 0);
+
+		sprintf(name, "CMapPtrToPtr %uM miss (%u found)", n / 1000000, nFound);
+		ReportTime(name, n, timer.GetSeconds());
+	}
+}
+
+void BenchPtrIdTable()
+{
+	static const unsigned int sizes[] = { 1000000, 5000000, 20000000 };
+
+	for (unsigned int i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+	{
+		void** keys = MakeKeys(sizes[i]);
+		BenchTable(sizes[i], keys);
+		delete [] keys;
+	}
+}
@@ -0,0 +1,176 @@
+#include "StdAfx.h"
+#include "NumberFormatter.h"
+#include "OutputBuffer.h"
+#include "TextEditWriter.h"
+#include "NullEditWriter.h"
+#include "Bench.h"
+
+// Measures how quickly text edit files get written, by passing the same synthetic stream
+// of items through TextEditWriter (over an OutputBuffer), and through StdioEditWriter (a
+// copy of the way TextEditWriter used to do things, with sprintf and fprintf for every value).
+
+namespace
+{
+	// Writes each value with sprintf, and then fprintf (the original TextEditWriter)
+	class StdioEditWriter : public IEditWriter
+	{
+	public:
+		StdioEditWriter(FILE* fp) : m_File(fp), m_NumIndent(0) {}
+
+		void WriteBeginObject() { WriteLine("{"); m_NumIndent++; }
+		void WriteEndObject() { m_NumIndent--; WriteLine("}"); }
+
+		void WriteArrayItem(unsigned int index, LPCTSTR typeName)
+		{
+			char name[16];
+			sprintf(name, "[%u]", index);
+			WriteValue(name, typeName);
+		}
+
+		void WriteByte(DataField field, byte value) { Write(field, "%d", (int)value); }
+		void WriteInt32(DataField field, int value) { Write(field, "%d", value); }
+		void WriteUInt32(DataField field, unsigned int value) { Write(field, "%u", value); }
+		void WriteInt64(DataField field, __int64 value) { Write(field, "%I64d", value); }
+		void WriteDouble(DataField field, double value) { Write(field, "%f", value); }
+		void WriteSingle(DataField field, float value) { Write(field, "%f", (double)value); }
+		void WriteBool(DataField field, bool value) { WriteValue(DataFields[field], value ? "1" : "0"); }
+		void WriteString(DataField field, LPCTSTR value) { WriteValue(DataFields[field], value); }
+		void WriteInternalId(DataField field, unsigned int id) { WriteUInt32(field, id); }
+		void WriteBytes(DataField field, const byte* data, unsigned int length) {}
+
+		void WriteDateTime(DataField field, const CTime& value)
+		{
+			WriteValue(DataFields[field], (LPCTSTR)value.Format("%Y-%m-%dT%H:%M:%S"));
+		}
+
+	private:
+		template <class T>
+		void Write(DataField field, LPCTSTR format, T value)
+		{
+			char buf[400];
+			sprintf(buf, format, value);
+			WriteValue(DataFields[field], buf);
+		}
+
+		void WriteValue(LPCTSTR name, LPCTSTR value)
+		{
+			if (value == 0)
+				WriteLine(name);
+			else
+			{
+				WriteIndent();
+				fprintf(m_File, "%s=%s\n", name, value);
+			}
+		}
+
+		void WriteLine(LPCTSTR line)
+		{
+			WriteIndent();
+			fprintf(m_File, "%s\n", line);
+		}
+
+		void WriteIndent()
+		{
+			for (int i=0; i<m_NumIndent; i++)
+				fputc('\t', m_File);
+		}
+
+		FILE* m_File;
+		int m_NumIndent;
+	};
+}
+
+// The number of items in the synthetic stream (each one is an object with 9 values)
+static const unsigned int NumItem = 500000;
+
+// Writes a stream of items that look like the points and lines in a typical export
+static void WriteItems(IEditWriter& w)
+{
+	CTime when(2011, 11, 17, 9, 30, 0);
+	char key[16];
+
+	for (unsigned int i=0; i<NumItem; i++)
+	{
+		bool isPoint = (i % 3 != 0);
+		w.WriteArrayItem(i, isPoint ? "PointFeature" : "LineFeature");
+		w.WriteBeginObject();
+		w.WriteInternalId(DataField_Id, i+1);
+		w.WriteDateTime(DataField_When, when);
+		w.WriteInt32(DataField_Entity, (int)(i % 37));
+
+		if (isPoint)
+		{
+			w.WriteDouble(DataField_X, 1234567.0 + i * 0.125);
+			w.WriteDouble(DataField_Y, 5432100.0 - i * 0.375);
+			sprintf(key, "P%u", 100000 + i);
+			w.WriteString(DataField_Key, key);
+		}
+		else
+		{
+			w.WriteInternalId(DataField_From, i);
+			w.WriteInternalId(DataField_To, i-1);
+			w.WriteString(DataField_Key, 0);
+		}
+
+		w.WriteInt64(DataField_ForeignKey, (__int64)i * 1000003);
+		w.WriteBool(DataField_Topological, isPoint);
+		w.WriteEndObject();
+	}
+}
+
+// Writes the synthetic items to a temporary file, returning the number of bytes written
+static unsigned __int64 WriteStdio()
+{
+	FILE* fp = tmpfile();
+	if (fp == 0)
+		return 0;
+
+	StdioEditWriter w(fp);
+	WriteItems(w);
+	fflush(fp);
+	unsigned __int64 numBytes = (unsigned __int64)_ftelli64(fp);
+	fclose(fp);
+	return numBytes;
+}
+
+static unsigned __int64 WriteText(bool toFile)
+{
+	FILE* fp = 0;
+	if (toFile && (fp = tmpfile()) == 0)
+		return 0;
+
+	unsigned __int64 numBytes;
+	{
+		OutputBuffer output(fp);
+		TextEditWriter w(output);
+		WriteItems(w);
+		output.Flush();
+		numBytes = output.GetTotalBytes();
+	}
+
+	if (fp != 0)
+		fclose(fp);
+
+	return numBytes;
+}
+
+void BenchTextWriter()
+{
+	BenchTimer timer;
+
+	NullEditWriter nw;
+	WriteItems(nw);
+	ReportTime("NullEditWriter (cost of the stream)", NumItem, timer.GetSeconds());
+
+	timer.Restart();
+	unsigned __int64 numBytes = WriteStdio();
+	ReportRate("sprintf + fprintf to file", numBytes, timer.GetSeconds());
+
+	timer.Restart();
+	numBytes = WriteText(true);
+	ReportRate("TextEditWriter to file", numBytes, timer.GetSeconds());
+
+	timer.Restart();
+	numBytes = WriteText(false);
+	ReportRate("TextEditWriter in memory", numBytes, timer.GetSeconds());
+}
@@ -0,0 +1,201 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include "BinaryEditWriter.h"
+
+const char BinaryEditWriter::Signature[4] = { 'B', 'S', 'E', 'D' };
+
+/// <summary>
+/// Writes the signature and version that identify a binary edit file. This should be
+/// called once, before anything else gets written to the file.
+/// </summary>
+void BinaryEditWriter::WriteHeader()
+{
+	m_Output.Append(Signature, sizeof(Signature));
+	m_Output.Append((char)Version);
+}
+
+/// <summary>
+/// Writes an unsigned byte to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="value">The unsigned byte to write.</param>
+void BinaryEditWriter::WriteByte(DataField field, byte value)
+{
+	WriteFixed<byte>(field, value);
+}
+
+/// <summary>
+/// Writes a four-byte signed integer to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="value">The four-byte signed integer to write.</param>
+void BinaryEditWriter::WriteInt32(DataField field, int value)
+{
+	WriteFixed<int>(field, value);
+}
+
+/// <summary>
+/// Writes a four-byte unsigned integer to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="value">The four-byte unsigned integer to write.</param>
+void BinaryEditWriter::WriteUInt32(DataField field, unsigned int value)
+{
+	WriteFixed<unsigned int>(field, value);
+}
+
+/// <summary>
+/// Writes an eight-byte signed integer to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="value">The eight-byte signed integer to write.</param>
+void BinaryEditWriter::WriteInt64(DataField field, __int64 value)
+{
+	WriteFixed<__int64>(field, value);
+}
+
+/// <summary>
+/// Writes an eight-byte floating-point value to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="value">The eight-byte floating-point value to write.</param>
+void BinaryEditWriter::WriteDouble(DataField field, double value)
+{
+	WriteFixed<double>(field, value);
+}
+
+/// <summary>
+/// Writes an four-byte floating-point value to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="value">The four-byte floating-point value to write.</param>
+void BinaryEditWriter::WriteSingle(DataField field, float value)
+{
+	WriteFixed<float>(field, value);
+}
+
+/// <summary>
+/// Writes a one-byte boolean value to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="value">The boolean value to write (0 or 1).</param>
+void BinaryEditWriter::WriteBool(DataField field, bool value)
+{
+	WriteFixed<byte>(field, (byte)(value ? 1 : 0));
+}
+
+/// <summary>
+/// Writes a string to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="value">The string to write (may be null).</param>
+void BinaryEditWriter::WriteString(DataField field, LPCTSTR value)
+{
+	WriteTag(field);
+	WriteStringValue(value);
+}
+
+/// <summary>
+/// Writes a timestamp to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="when">The timestamp to write</param>
+void BinaryEditWriter::WriteDateTime(DataField field, const CTime& value)
+{
+	WriteFixed<__int64>(field, (__int64)value.GetTime());
+}
+
+/// <summary>
+/// Writes an internal ID to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="id">The internal ID to write</param>
+void BinaryEditWriter::WriteInternalId(DataField field, unsigned int id)
+{
+	WriteFixed<unsigned int>(field, id);
+}
+
+/// <summary>
+/// Writes an array of bytes to a storage medium.
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="data">The bytes to write</param>
+/// <param name="length">The number of bytes to write</param>
+void BinaryEditWriter::WriteBytes(DataField field, const byte* data, unsigned int length)
+{
+	WriteTag(field);
+	byte* p = (byte*)m_Output.Reserve(10 + length);
+	unsigned int nb = FormatVarint(p, length);
+	memcpy(p + nb, data, length);
+	m_Output.Commit(nb + length);
+}
+
+/// <summary>
+/// Writes the type name for an element in an array of objects.
+/// </summary>
+/// <param name="index">The array index of the element (0 for the first element)</param>
+/// <param name="typeName">The exported type name of the element.</param>
+void BinaryEditWriter::WriteArrayItem(unsigned int index, LPCTSTR typeName)
+{
+	byte* p = (byte*)m_Output.Reserve(11);
+	p[0] = ArrayItemMarker;
+	m_Output.Commit(1 + FormatVarint(p+1, index));
+
+	WriteStringValue(typeName);
+}
+
+/// <summary>
+/// Writes the marker that precedes the data values for an object.
+/// </summary>
+void BinaryEditWriter::WriteBeginObject()
+{
+	m_Output.Append((char)BeginObjectMarker);
+}
+
+/// <summary>
+/// Writes the marker that follows the data values for an object.
+/// </summary>
+void BinaryEditWriter::WriteEndObject()
+{
+	m_Output.Append((char)EndObjectMarker);
+}
+
+// Writes the one-byte tag that identifies an item
+void BinaryEditWriter::WriteTag(DataField field)
+{
+	assert(field >= 0 && field < ArrayItemMarker);
+	m_Output.Append((char)field);
+}
+
+// Writes a string as a varint (the length plus one, or 0 for a null string), followed
+// by the characters (with no trailing null)
+void BinaryEditWriter::WriteStringValue(LPCTSTR value)
+{
+	if (value == 0)
+	{
+		m_Output.Append((char)0);
+		return;
+	}
+
+	unsigned int len = (unsigned int)strlen(value);
+	byte* p = (byte*)m_Output.Reserve(10 + len);
+	unsigned int nb = FormatVarint(p, (unsigned __int64)len + 1);
+	memcpy(p + nb, value, len);
+	m_Output.Commit(nb + len);
+}
+
+// Writes a value using 7 bits per byte (least significant group first), with the high
+// bit set on every byte except the last. Returns the number of bytes written (at most 10).
+unsigned int BinaryEditWriter::FormatVarint(byte* buf, unsigned __int64 value)
+{
+	unsigned int n = 0;
+
+	while (value >= 0x80)
+	{
+		buf[n++] = (byte)(value | 0x80);
+		value >>= 7;
+	}
+
+	buf[n++] = (byte)value;
+	return n;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "IEditWriter.h"
+#include "OutputBuffer.h"
+
+/// <summary>
+/// Writes edits in a compact binary form (an alternative to <see cref="TextEditWriter"/>),
+/// as read by the BinaryEditReader class in Backsight.Editor.
+/// </summary>
+/// <remarks>
+/// Each item starts with a one-byte tag holding its DataField value. The values that follow
+/// are written in little-endian order, and are the same width as the corresponding type
+/// (bytes and bools take 1 byte, 32-bit integers and floats take 4, while 64-bit integers
+/// and doubles take 8). Timestamps are written as 64-bit time_t values. Strings are written as
+/// a varint holding the length plus one (so a null string is just a zero), followed by
+/// the characters. Arrays of bytes are written the same way as strings (but with a length
+/// that doesn't have one added, since they can't be null). Objects are bracketed by the BeginObject and EndObject marker bytes, while
+/// the elements of an array are tagged with the ArrayItem marker plus a varint index.
+/// <para/>
+/// Since DataField values now get persisted, any new fields must be appended to the
+/// end of the DataField enum.
+/// </remarks>
+class BinaryEditWriter : public IEditWriter
+{
+public:
+	// Identifies the start of a binary edit file (followed by a one-byte format version)
+	static const char Signature[4];
+	static const byte Version = 1;
+
+	// Marker bytes (these lie beyond the range of DataField values)
+	static const byte BeginObjectMarker = 0xFD;
+	static const byte EndObjectMarker = 0xFE;
+	static const byte ArrayItemMarker = 0xFC;
+
+	BinaryEditWriter(OutputBuffer& output) : m_Output(output) {}
+	virtual ~BinaryEditWriter(void) {}
+
+	void WriteHeader();
+
+	void WriteBeginObject();
+	void WriteEndObject();
+	void WriteArrayItem(unsigned int index, LPCTSTR typeName);
+	void WriteByte(DataField field, byte value);
+    void WriteInt32(DataField field, int value);
+    void WriteUInt32(DataField field, unsigned int value);
+    void WriteInt64(DataField field, __int64 value);
+    void WriteDouble(DataField field, double value);
+    void WriteSingle(DataField field, float value);
+    void WriteBool(DataField field, bool value);
+    void WriteString(DataField field, LPCTSTR value);
+    void WriteDateTime(DataField field, const CTime& value);
+    void WriteInternalId(DataField field, unsigned int id);
+    void WriteBytes(DataField field, const byte* data, unsigned int length);
+
+	static unsigned int FormatVarint(byte* buf, unsigned __int64 value);
+
+private:
+	void WriteTag(DataField field);
+	void WriteStringValue(LPCTSTR value);
+
+	// Appends a fixed-width value (the x86 byte order is already little-endian)
+	template <class T> void WriteFixed(DataField field, T value)
+	{
+		byte* p = (byte*)m_Output.Reserve(1 + sizeof(T));
+		p[0] = (byte)field;
+		memcpy(p+1, &value, sizeof(T));
+		m_Output.Commit(1 + sizeof(T));
+	}
+
+private:
+	OutputBuffer& m_Output;
+};
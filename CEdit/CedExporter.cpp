@@ -15,9 +15,19 @@
 #endif
 
 #include "Changes.h"
+#include "OutputBuffer.h"
 #include "TextEditWriter.h"
+#include "BinaryEditWriter.h"
+#include "NullEditWriter.h"
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
 #include "EditSerializer.h"
 #include "Features.h"
+#include "ObjectScanner.h"
+#include "EditFileWriter.h"
+#include "ExportArena.h"
+#include "ExportState.h"
+#include "ExportStats.h"
 #include "CedExporter.h"
 
 
@@ -27,12 +37,44 @@ CedExporter::CedExporter()
 {
 }
 
+CedExporter::CedExporter(const ExportOptions& options)
+	: m_Options(options)
+{
+}
+
 CedExporter::~CedExporter(void)
 {
 }
 
 #pragma comment(lib, "rpcrt4.lib")
 
+// Creates a writer for an export format. The output buffer may be null if the null
+// writer has been requested. For the binary format, the caller is responsible for
+// writing the file header (just once, at the start of the file).
+// static
+IEditWriter* CedExporter::CreateEditWriter(ExportFormat format, OutputBuffer* output)
+{
+	switch (format)
+	{
+	case ExportFormat_Binary:
+		return new BinaryEditWriter(*output);
+
+	case ExportFormat_Null:
+		return new NullEditWriter();
+	}
+
+	return new TextEditWriter(*output);
+}
+
+// Returns the file extension for the edit file (without the dot)
+LPCTSTR CedExporter::GetEditFileExtension() const
+{
+	if (m_Options.Format == ExportFormat_Binary)
+		return (m_Options.CompressionLevel > 0 ? "bin.gz" : "bin");
+
+	return (m_Options.CompressionLevel > 0 ? "txt.gz" : "txt");
+}
+
 void CedExporter::FillGuidString(CString& s) const
 {
 	// See http://forums.codeguru.com/showthread.php?t=379736
@@ -56,50 +98,203 @@ void CedExporter::FillComputerName(CString& name) const
 	name = cname;
 }
 
+// Reads the project ID from the index entry written by a previous export
+bool CedExporter::ReadProjectId(LPCTSTR indexFileName, CString& guid) const
+{
+	FILE* fp = fopen(indexFileName, "r");
+	if (fp == 0)
+		return false;
+
+	char buf[128];
+	bool ok = (fgets(buf, sizeof(buf), fp) != 0);
+	fclose(fp);
+
+	guid = buf;
+	guid.TrimRight();
+	return (ok && guid.GetLength() > 0);
+}
+
+// Checks that the sessions written by a previous export are still in the CED file (and
+// that something has been added since then). If not, the user is told why and false is
+// returned.
+bool CedExporter::CheckPreviousSessions(CeMap* cedFile, const ExportState& previous) const
+{
+	CPSEPtrList& sessions = cedFile->GetSessions();
+	unsigned int numSession = (unsigned int)sessions.GetCount();
+
+	if (previous.NumSession > numSession)
+	{
+		AfxMessageBox("Map has fewer sessions than when it was previously exported");
+		return false;
+	}
+
+	// The previous export finished at the end of a session, so compare that session with
+	// what it looked like then (any edits added to it since then would get missed)
+	if (previous.NumSession > 0)
+	{
+		POSITION pos = sessions.FindIndex(previous.NumSession-1);
+		CeSession* session = (CeSession*)sessions.GetAt(pos);
+		__int64 start = (__int64)session->GetStart().GetTimeValue();
+		unsigned int nop = (unsigned int)session->GetOperations().GetCount();
+
+		if (start != previous.LastSessionStart || nop != previous.LastSessionOps)
+		{
+			AfxMessageBox("Sessions have changed since the map was previously exported");
+			return false;
+		}
+	}
+
+	if (previous.NumSession == numSession)
+	{
+		AfxMessageBox("Nothing has been added since the map was previously exported");
+		return false;
+	}
+
+	return true;
+}
+
 #ifdef _CEDIT
 #include "CeExportTypeUtil.h"
 #include "CeTableEx.h"
 #endif
 
+// Exports a map. If the map has been exported before, the export carries on from where the
+// previous one finished (if the options allow it). If it turns out that the previous export
+// can't be carried on from, the map gets exported in full instead.
 void CedExporter::CreateExport(CeMap* cedFile)
+{
+	// A full export never asks for a restart, so this only ever goes round once more
+	if (RunExport(cedFile, false) == ExportResult_Restart)
+		RunExport(cedFile, true);
+}
+
+// Sets aside the project written by a previous export, so that nothing carries on from it
+// again. The state and the index entry are deleted, but the project folder is just renamed
+// (with a ".superseded" suffix), since its edit files may already have been loaded elsewhere.
+void CedExporter::SupersedeProject(LPCTSTR projectFolder, LPCTSTR stateFileName, LPCTSTR indexFileName) const
+{
+	DeleteFile(stateFileName);
+	DeleteFile(indexFileName);
+
+	CString newName;
+	newName.Format("%s.superseded", projectFolder);
+	if (!MoveFile(projectFolder, (LPCTSTR)newName))
+	{
+		CString msg;
+		msg.Format("Cannot rename %s (the previous export is no longer in use, and can be deleted)", projectFolder);
+		AfxMessageBox(msg);
+	}
+}
+
+// Exports a map, carrying on from a previous export if there is one (unless a full export is
+// requested). Nothing gets carried on from a previous export that turns out not to match the
+// map (it's set aside, and a restart is requested).
+CedExporter::ExportResult CedExporter::RunExport(CeMap* cedFile, bool isFullExport)
 {
 	//CleanObjectLists(cedFile);
-	//return;
+	//return ExportResult_Done;
+
+	ExportStats stats;
+	__int64 exportStart = ExportStats::Now();
 
 	// Ensure root folders exist (methods will quietly fail if folders are already there)
 	CreateDirectory("C:\\Backsight", 0);
 	CreateDirectory("C:\\Backsight\\index", 0);
 
-	// Ensure the export has not been done already by looking for an existing index entry
+	// Ensure the export has not been done already by looking for an existing index entry (unless
+	// the export can carry on from where the previous export finished)
 	LPCTSTR mapName = cedFile->GetFileName();
 	CString indexFileName;
 	indexFileName.Format("C:\\Backsight\\index\\%s.txt", mapName);
 	CFileStatus fileStatus;
-	if (CFile::GetStatus((LPCTSTR)indexFileName, fileStatus))
+	bool isIncremental = (!isFullExport && CFile::GetStatus((LPCTSTR)indexFileName, fileStatus) == TRUE);
+	if (isIncremental && !m_Options.Incremental)
 	{
 		AfxMessageBox("Map has been exported previously");
-		return;
+		return ExportResult_Failed;
+	}
+
+	// Generate a GUID for the project (or pick up the one from the previous export)
+	CString guid;
+	if (isIncremental)
+	{
+		if (!ReadProjectId((LPCTSTR)indexFileName, guid))
+		{
+			AfxMessageBox("Cannot read the index entry for the previous export");
+			return ExportResult_Failed;
+		}
+	}
+	else
+		FillGuidString(guid);
+
+	// The state of an incremental export gets saved in the project folder
+	CString stateFileName;
+	stateFileName.Format("C:\\Backsight\\%s\\export.state", (LPCTSTR)guid);
+	ExportState previous;
+	ExportState state;
+	unsigned int firstSession = 0;
+
+	if (isIncremental)
+	{
+		if (!previous.Load((LPCTSTR)stateFileName))
+		{
+			AfxMessageBox("Cannot load the state saved by the previous export");
+			return ExportResult_Failed;
+		}
+
+		if (!CheckPreviousSessions(cedFile, previous))
+			return ExportResult_Failed;
+
+		firstSession = previous.NumSession;
 	}
 
 	IdFactory idFactory;
 	CPtrArray items;
 
-	// Generate a GUID for the project
-	CString guid;
-	FillGuidString(guid);
+	// When the state is being saved, the scan needs to note a stable key for each feature (and
+	// IDs allocated by the previous export need to be restored before anything else gets an ID)
+	if (m_Options.Incremental)
+		idFactory.TrackStableKeys(isIncremental ? &previous : 0);
+
+	// Place the export items in an arena, so they can be discarded in one go
+	ExportArena arena;
 
 	// Record the current computer name
 	CString machineName;
 	FillComputerName(machineName);
 
+	// Create the project folder (unless nothing is being written)
+	CString projectFolder;
+	projectFolder.Format("C:\\Backsight\\%s", (LPCTSTR)guid);
+	bool isNull = (m_Options.Format == ExportFormat_Null);
+	if (!isNull)
+		CreateDirectory((LPCTSTR)projectFolder, 0);
+
+	// The edit file is named after the last ID that gets allocated, which won't be known until
+	// everything has been processed. So write it under a temporary name to begin with.
+	CString tempFileName;
+	tempFileName.Format("%s\\edits.tmp", (LPCTSTR)projectFolder);
+	CString tempIndexName;
+	tempIndexName.Format("%s\\index.tmp", (LPCTSTR)projectFolder);
+	EditFileWriter editFile(idFactory, m_Options);
+	if (!editFile.Open((LPCTSTR)tempFileName, (LPCTSTR)tempIndexName))
+	{
+		CString msg;
+		msg.Format("Cannot create %s", (LPCTSTR)tempFileName);
+		AfxMessageBox(msg);
+		return ExportResult_Failed;
+	}
+
 	// Create the new project event (assuming UTM zone 14 on NAD83)
 	CTime now = CTime::GetCurrentTime();
 	int layerId = 10; // Survey layer
-	items.Add(new NewProjectEvent_c(idFactory, now, (LPCTSTR)guid, mapName, layerId, "UTM83-14", "CEdit", (LPCTSTR)machineName));
+	if (!isIncremental)
+		items.Add(new NewProjectEvent_c(idFactory, now, (LPCTSTR)guid, mapName, layerId, "UTM83-14", "CEdit", (LPCTSTR)machineName));
 
 	// Invent a pseudo-session to enclose all ID allocations (and any other stuff)
 	items.Add(new NewSessionEvent_c(idFactory, now, "CEdit", ""));
 
+	__int64 t = ExportStats::Now();
 	CeIdManager* idMan = CeIdHandle::GetIdManager();
 	unsigned int nGroup = idMan->GetNumGroup();
 
@@ -113,19 +308,87 @@ void CedExporter::CreateExport(CeMap* cedFile)
 		while ( pos )
 		{
 			CeIdRange* range = (CeIdRange*)ranges.GetNext(pos);
-			items.Add(new IdAllocation_c(idFactory, now, groupId, range->GetMin(), range->GetMax()));
+			state.AddIdRange(groupId, range->GetMin(), range->GetMax());
+
+			// Skip any allocation that was written by the previous export (if the range has
+			// been extended since then, just the new part gets written)
+			if (isIncremental)
+			{
+				CUIntArray parts;
+				previous.GetUnwrittenIdRanges(groupId, range->GetMin(), range->GetMax(), parts);
+
+				for (int j=0; j+1<parts.GetSize(); j+=2)
+					items.Add(new IdAllocation_c(idFactory, now, groupId, parts.GetAt(j), parts.GetAt(j+1)));
+			}
+			else
+				items.Add(new IdAllocation_c(idFactory, now, groupId, range->GetMin(), range->GetMax()));
 		}
 	}
 
+	stats.AddPhase("IdAllocation", t);
+
 	// Produce a definitive (correct) list of the features created
 	// be each edit. This aims to overcome a defect in the lists associated
-	// with CeImport edits (and perhaps other edits).
-	idFactory.GenerateOperationFeatureLists(cedFile);
+	// with CeImport edits (and perhaps other edits). This involves a scan
+	// through the entire database, so do any validation at the same time.
+	ObjectScanner scanner(cedFile);
+	scanner.Add(&idFactory);
+
+	ValidObjectIndex* validObjects = 0;
+	ObjectListValidator* listValidator = 0;
+	if (m_Options.ValidateObjectLists)
+	{
+		validObjects = new ValidObjectIndex();
+		listValidator = new ObjectListValidator(*validObjects);
+		scanner.Add(validObjects);
+		scanner.Add(listValidator);
+	}
+
+	t = ExportStats::Now();
+	stats.SetCounter("ObjectsScanned", scanner.Run());
+	stats.AddPhase("ObjectScan", t);
+
+	if (listValidator != 0)
+	{
+		CString summary;
+		listValidator->GetSummary(summary);
+		AfxMessageBox(summary);
+
+		delete listValidator;
+		delete validObjects;
+	}
+
+	// If any of the IDs saved by the previous export now seem to belong to a different feature,
+	// none of them can be trusted. Discard what has been done so far, set aside the previous
+	// project, and get the caller to start again with a full export (as a new project).
+	if (isIncremental && idFactory.GetNumMismatched() > 0)
+	{
+		CString msg;
+		msg.Format("%u features no longer match the state saved by the previous export, so the map will be exported in full",
+			idFactory.GetNumMismatched());
+		AfxMessageBox(msg);
+
+		for (int i=0; i<items.GetSize(); i++)
+			delete (Persistent_c*)items.GetAt(i);
+
+		items.RemoveAll();
+		editFile.Close();
+		DeleteFile((LPCTSTR)tempFileName);
+		DeleteFile((LPCTSTR)tempIndexName);
+
+		if (!isNull)
+			SupersedeProject((LPCTSTR)projectFolder, (LPCTSTR)stateFileName, (LPCTSTR)indexFileName);
+
+		return ExportResult_Restart;
+	}
 	
 	// Generate any points that will be needed for line ends (whereas CEdit would let you have lines without
 	// an end point, Backsight requires them)
+	t = ExportStats::Now();
 	ImportOperation_c* extra = new ImportOperation_c(idFactory, now);
-	GenerateExtraPoints(cedFile, idFactory, extra->Features);
+	GenerateExtraPoints(cedFile, idFactory, extra->Features, firstSession);
+	stats.AddPhase("GenerateExtraPoints", t);
+	stats.SetCounter("ExtraPoints", extra->Features.GetSize());
 	//AfxMessageBox("done extra points");
 
 	// Represent the points as an import operation
@@ -136,20 +399,38 @@ void CedExporter::CreateExport(CeMap* cedFile)
 
 	items.Add(new EndSessionEvent_c(idFactory, now));
 
-	// Now loop through each session (but ignore empty sessions).
+	// When streaming, write out (and delete) items as soon as they're complete
+	if (m_Options.Streaming)
+	{
+		t = ExportStats::Now();
+		editFile.WriteItems(items);
+		arena.Reset();
+		stats.AddPhase("Serialization", t);
+	}
+
+	// Now loop through each session (but ignore empty sessions, and any sessions that were
+	// written by the previous export).
 	CPSEPtrList& sessions = cedFile->GetSessions();
 	POSITION spos = sessions.GetHeadPosition();
 	int totop = 0;
+	unsigned int sessionIndex = 0;
+	CeSession* lastSession = 0;
 
 	while (spos != 0)
 	{
 		CeSession* session = (CeSession*)sessions.GetNext(spos);
+		lastSession = session;
+		if (sessionIndex++ < firstSession)
+			continue;
+
 		const CPSEPtrList& ops = session->GetOperations();
 		int nop = ops.GetCount();
 		totop += nop;
 
 		if (nop > 0)
 		{
+			t = ExportStats::Now();
+
 			// Append the NewSessionEvent
 			CTime startTime(session->GetStart().GetTimeValue());
 			CTime endTime(session->GetEnd().GetTimeValue());
@@ -166,66 +447,145 @@ void CedExporter::CreateExport(CeMap* cedFile)
 				LONG secs = (i+1) * secsPerEdit;
 				CTimeSpan delta(0,0,0, secs);
 				CTime when = startTime + delta;
+
+				__int64 opStart = ExportStats::Now();
+				int numItem = items.GetSize();
 				AppendExportItems(when, *op, idFactory, items);
+				stats.AddOperation((int)op->GetType(), (unsigned int)(items.GetSize() - numItem), opStart);
 			}
 
 			// Append the end session event
 			items.Add(new EndSessionEvent_c(idFactory, endTime));
+			stats.AddPhase("ItemConstruction", t);
+
+			if (m_Options.Streaming)
+			{
+				t = ExportStats::Now();
+				editFile.WriteItems(items);
+				arena.Reset();
+				stats.AddPhase("Serialization", t);
+			}
 		}
 	}
 
 	// Clear the lists of features associated with each edit
 	idFactory.ClearOperationFeatureLists();
 
-	// test
-	CString t;
-	t.Format("Number of edits=%d", totop);
-	AfxMessageBox(t);
-	//return;
+	// Write whatever hasn't been written already (when not streaming, that's everything)
+	t = ExportStats::Now();
+	editFile.WriteItems(items);
+	arena.Reset();
+	stats.AddPhase("Serialization", t);
+
+	t = ExportStats::Now();
+	CString summary;
+	editFile.Close();
+	stats.AddPhase("CloseEditFile", t);
+	editFile.GetSummary(summary);
+
+	stats.SetCounter("Edits", totop);
+	stats.SetCounter("Items", editFile.GetNumItems());
+	stats.SetCounter("EditStreamBytes", editFile.GetNumBytes());
+	idFactory.GetCounters(stats);
+
+	CString arenaSummary;
+	arena.GetSummary(arenaSummary);
+	summary += "\n";
+	summary += arenaSummary;
+
+	if (isIncremental)
+	{
+		CString s;
+		s.Format("\nSessions skipped=%u\nIDs restored from previous export=%u", firstSession, idFactory.GetNumRestored());
+		summary += s;
+	}
 
-	// Create the project folder
-	CString projectFolder;
-	projectFolder.Format("C:\\Backsight\\%s", (LPCTSTR)guid);
-	CreateDirectory((LPCTSTR)projectFolder, 0);
+	// A null export is only done for timing purposes, so there's nothing more to do (there's
+	// no project folder, so the report goes in the root folder)
+	if (isNull)
+	{
+		WriteReport(stats, exportStart, "C:\\Backsight\\ExportStats.json", mapName, (LPCTSTR)guid, summary);
+		AppendPeakMemory(summary);
+		AfxMessageBox((LPCTSTR)summary);
+		return ExportResult_Done;
+	}
 
-	// Produce the output file
+	// Give the edit file its proper name
 	unsigned int maxId = idFactory.GetNextId();
 	CString fileName;
-	fileName.Format("%s\\%u.txt", (LPCTSTR)projectFolder, maxId);
+	fileName.Format("%s\\%u.%s", (LPCTSTR)projectFolder, maxId, GetEditFileExtension());
+	MoveFile((LPCTSTR)tempFileName, (LPCTSTR)fileName);
 
-	FILE* fp = fopen((LPCTSTR)fileName, "w");
-	TextEditWriter* tw = new TextEditWriter(fp);
-	EditSerializer* es = new EditSerializer(idFactory, *tw);
+	CFileStatus editFileStatus;
+	if (CFile::GetStatus((LPCTSTR)fileName, editFileStatus))
+		stats.SetCounter("EditFileBytes", (unsigned __int64)editFileStatus.m_size);
 
-	for (int ix=0; ix<items.GetSize(); ix++)
+	// The index (if any) goes alongside, as index-<maxId>.idx (the name mustn't be just a
+	// number, since anything like that gets loaded as an edit file)
+	if (editFile.HasIndex())
 	{
-		Persistent_c* p = (Persistent_c*)items.GetAt(ix);
-		es->WritePersistent(DataField_Edit, *p);
+		CString idxFileName;
+		idxFileName.Format("%s\\index-%u.idx", (LPCTSTR)projectFolder, maxId);
+		MoveFile((LPCTSTR)tempIndexName, (LPCTSTR)idxFileName);
 	}
 
-	delete es;
-	delete tw;
-	fclose(fp);
+	// Save the state for the next incremental export (the edit file name has consumed an ID, so
+	// the next export will start after it)
+	if (m_Options.Incremental)
+	{
+		state.NumSession = sessionIndex;
+		if (lastSession != 0)
+		{
+			state.LastSessionStart = (__int64)lastSession->GetStart().GetTimeValue();
+			state.LastSessionOps = (unsigned int)lastSession->GetOperations().GetCount();
+		}
 
-	// Write the index entry file
-	fp = fopen((LPCTSTR)indexFileName, "w");
-	fprintf(fp, "%s", (LPCTSTR)guid);
-	fclose(fp);
+		unsigned int numSkip = idFactory.SaveState(state);
+
+		CString s;
+		if (state.Save((LPCTSTR)stateFileName))
+			s.Format("\nExport state saved (features=%u, locations=%u, not saved=%u)",
+				state.GetNumFeature(), state.GetNumLocation(), numSkip);
+		else
+			s = "\nCould not save the export state";
+
+		summary += s;
+	}
+
+	// Write the index entry file (if this is the first export of the map)
+	if (!isIncremental)
+	{
+		FILE* fp = fopen((LPCTSTR)indexFileName, "w");
+		fprintf(fp, "%s", (LPCTSTR)guid);
+		fclose(fp);
+	}
 	
 	// Write point positions file
+	t = ExportStats::Now();
 	CString ptsFileName;
 	ptsFileName.Format("%s\\%s.pts", (LPCTSTR)projectFolder, mapName);
 	idFactory.WritePointsFile((LPCTSTR)ptsFileName);
+	stats.AddPhase("PointsFile", t);
+
+	// Dump out attributes
+	t = ExportStats::Now();
+	ExportAttributes(cedFile, (LPCTSTR)projectFolder, mapName);
+	stats.AddPhase("Attributes", t);
+
+	// The report on how the export went goes alongside the edit file, as export-<maxId>.json
+	// (like the index, it mustn't be named after just the number)
+	CString reportFileName;
+	reportFileName.Format("%s\\export-%u.json", (LPCTSTR)projectFolder, maxId);
+	WriteReport(stats, exportStart, (LPCTSTR)reportFileName, mapName, (LPCTSTR)guid, summary);
+
+	AppendPeakMemory(summary);
+	AfxMessageBox((LPCTSTR)summary);
+	return ExportResult_Done;
+}
 
-	// Remove the export objects
-	for (int ip=0; ip<items.GetSize(); ip++)
-	{
-		Persistent_c* p = (Persistent_c*)items.GetAt(ip);
-		delete p;
-	}
-
-	// Dump out attributes...
-
+// Writes out the attributes attached to the IDs in the CED file (one file per table)
+void CedExporter::ExportAttributes(CeMap* cedFile, LPCTSTR projectFolder, LPCTSTR mapName)
+{
 	// Obtain the mapping from schema to output file extension (for consistency with
 	// current data distributions done by GeoManitoba).
 	CeExportTypeUtil xt;
@@ -261,7 +621,7 @@ void CedExporter::CreateExport(CeMap* cedFile)
 
 		// Determine the name of the output file (based on the name of the schema)
 		const CeSchema& schema = pTable->GetSchema();
-		tableFileName.Format("%s\\%s-%s.txt", (LPCTSTR)projectFolder, mapName, xt.GetFileType(schema));
+		tableFileName.Format("%s\\%s-%s.txt", projectFolder, mapName, xt.GetFileType(schema));
 
 		// Write out the attributes
 		pTable->Export((LPCTSTR)tableFileName);
@@ -272,98 +632,66 @@ void CedExporter::CreateExport(CeMap* cedFile)
 	tables.RemoveAll();
 }
 
-
-#ifdef _CEDIT
-#include "CeObjectList.h"
-#endif
-
-void CedExporter::LoadValidData(CMapPtrToPtr& validData, CeMap* cedFile)
+// Finishes off the statistics for an export, and writes them to a JSON report. The time
+// taken by each phase gets appended to the summary message.
+void CedExporter::WriteReport(ExportStats& stats, __int64 exportStart, LPCTSTR fileName,
+								LPCTSTR mapName, LPCTSTR projectId, CString& summary) const
 {
-#ifdef _CEDIT
-	// Generate an index of valid objects
-	void* ptr=0;
-	os_typespec* curts=0;
-	os_int32 count=0;
-	os_object_cursor c(os_database::of(cedFile));
+	stats.AddPhase("Total", exportStart);
+	stats.SetCounter("PeakWorkingSetBytes", GetPeakMemory());
+
+	CString s;
+	stats.GetSummary(s);
+	summary += "\n";
+	summary += s;
 
-	for ( c.first(); c.more(); c.next() )
+	if (!stats.WriteReport(fileName, mapName, projectId, m_Options))
 	{
-		if ( c.current(ptr,curts,count) )
-		{
-			validData.SetAt(ptr, 0);
-		}
+		s.Format("\nCould not write %s", fileName);
+		summary += s;
 	}
+}
 
-	CString a;
-	a.Format("Number of objects=%d", validData.GetCount());
-	AfxMessageBox(a);
-#endif
+// Returns the peak memory usage (working set) of the process, in bytes
+unsigned __int64 CedExporter::GetPeakMemory() const
+{
+	PROCESS_MEMORY_COUNTERS pmc;
+	pmc.cb = sizeof(pmc);
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return (unsigned __int64)pmc.PeakWorkingSetSize;
+
+	return 0;
 }
 
-void CedExporter::CleanObjectLists(CeMap* cedFile)
+// Appends a note about the peak memory usage of the process to a message
+void CedExporter::AppendPeakMemory(CString& msg) const
 {
-#ifdef _CEDIT
-	// Generate an index of valid objects
-	CMapPtrToPtr validData;
-	LoadValidData(validData, cedFile);
-
-	// Scan again for lists. For each list, count how many refer to
-	// invalid objects
-
-	void* ptr=0;
-	os_typespec* curts=0;
-	os_int32 count=0;
-	os_object_cursor c(os_database::of(cedFile));
-	int nBad = 0;
-	int nCheck = 0;
-	int nSkip = 0;
-
-	for ( c.first(); c.more(); c.next() )
-	{
-		if ( c.current(ptr,curts,count) )
-		{
-			if (count > 1)
-			{
-				int junk = 0;
-				continue;
-			}
+	CString s;
+	s.Format("\nPeak memory (working set)=%u MB", (unsigned int)(GetPeakMemory() / (1024*1024)));
+	msg += s;
+}
 
-			nCheck++;
-			CeClass* pc = (CeClass*)ptr;
-			objectstore::touch(pc, false);
 
-			if (ptr == (void*)0x3039a900 ||
-				ptr == (void*)0x30399b88 ||
-				ptr == (void*)0x30399660 ||
-				ptr == (void*)0x303988c0 ||
-				ptr == (void*)0x30398df8)
-			{
-				nSkip++;
-				continue;
-			}
+#ifdef _CEDIT
+#include "CeObjectList.h"
+#endif
 
-			CeObjectList* pList = dynamic_cast<CeObjectList*>(pc);
-			if (pList)
-			{
-				CeFixedArray<CeClass*> stuff(*pList);
-				UINT4 numobj = stuff.GetCount();
+// Checks whether the object lists in the CED file refer to anything that
+// isn't in the database (for diagnostic purposes)
+void CedExporter::CleanObjectLists(CeMap* cedFile)
+{
+	ValidObjectIndex validObjects;
+	ObjectListValidator listValidator(validObjects);
 
-				for ( UINT4 i=0; i<numobj; i++ )
-				{
-					void* pThing = (void*)stuff[i];
-					void* pRes;
-					if (!validData.Lookup(pThing, pRes))
-						nBad++;
-				}
-			}
-		}
-	}
+	ObjectScanner scanner(cedFile);
+	scanner.Add(&validObjects);
+	scanner.Add(&listValidator);
+	scanner.Run();
 
 	CString t;
-	t.Format("Number of bad refs=%d (nCheck=%d) (nSkip=%d)", nBad, nCheck, nSkip);
+	listValidator.GetSummary(t);
 	AfxMessageBox(t);
-
-#endif
 }
 
 #ifdef _CEDIT
@@ -537,21 +865,27 @@ void CedExporter::AppendExportItems(const CTime& when, const CeOperation& op, Id
 #include "CeOffsetPoint.h"
 #endif
 
-void CedExporter::GenerateExtraPoints(CeMap* cedFile, IdFactory& idf, CPtrArray& extraPoints)
+// Generates points for line terminals that don't have one. Sessions before firstSession are
+// skipped (they were dealt with by a previous export).
+void CedExporter::GenerateExtraPoints(CeMap* cedFile, IdFactory& idf, CPtrArray& extraPoints, unsigned int firstSession)
 {
 	CPSEPtrList& sessions = cedFile->GetSessions();
 	POSITION spos = sessions.GetHeadPosition();
 	CeObjectList features;
+	unsigned int sessionIndex = 0;
 
 	// Index of the locations that have been accounted for - the key is a CeLocation pointer,
 	// the value is unused.
-	CMapPtrToPtr locIndex;
+	PtrIdTable locIndex(64*1024);
 
 	LogFile = fopen("C:\\Backsight\\Export.txt", "w");
 
 	while (spos != 0)
 	{
 		CeSession* session = (CeSession*)sessions.GetNext(spos);
+		if (sessionIndex++ < firstSession)
+			continue;
+
 		const CPSEPtrList& ops = session->GetOperations();
 		POSITION opos = ops.GetHeadPosition();
 
@@ -574,7 +908,7 @@ void CedExporter::GenerateExtraPoints(CeMap* cedFile, IdFactory& idf, CPtrArray&
 				{
 					// Note ALL coincident locations (since those may have been used as line
 					// terminals rather than the original location).
-					RecordLocations(*point, locIndex);
+					RecordLocations(*point, idf, locIndex);
 				}
 			}
 
@@ -626,11 +960,12 @@ void CedExporter::GenerateExtraPoints(CeMap* cedFile, IdFactory& idf, CPtrArray&
 	LogFile = 0;
 }
 
-void CedExporter::CheckForExtraPoint(const CeLocation* loc, CMapPtrToPtr& locIndex, IdFactory& idf, CPtrArray& extraPoints)
+void CedExporter::CheckForExtraPoint(const CeLocation* loc, PtrIdTable& locIndex, IdFactory& idf, CPtrArray& extraPoints)
 {
-	// Nothing to do if the location has already been noted
-	void* x;
-	if (locIndex.Lookup((void*)loc, x))
+	// Nothing to do if the location has already been noted (or it got an ID from a
+	// previous export)
+	unsigned int x;
+	if (locIndex.Lookup(loc, x) || idf.FindId((void*)loc) != 0)
 		return;
 
 	CString msg;
@@ -645,10 +980,10 @@ void CedExporter::CheckForExtraPoint(const CeLocation* loc, CMapPtrToPtr& locInd
 	//Log(msg);
 
 	extraPoints.Add(p);
-	locIndex.SetAt((void*)loc, (void*)p->Stub->InternalId); // I don't think we really need the ID, but hold it just in case
+	locIndex.SetAt(loc, p->Stub->InternalId); // I don't think we really need the ID, but hold it just in case
 }
 
-void CedExporter::RecordLocations(const CePoint& p, CMapPtrToPtr& locIndex) 
+void CedExporter::RecordLocations(const CePoint& p, IdFactory& idf, PtrIdTable& locIndex) 
 {
 	//CString s;
 	//s.Format("Process point %s", p.FormatKey());
@@ -660,7 +995,7 @@ void CedExporter::RecordLocations(const CePoint& p, CMapPtrToPtr& locIndex)
 
 	CPtrArray locs;
 	const CeLocation* loc = p.GetpVertex();
-	GetAllCoincidentLocations(loc, locs, LogFile);
+	idf.GetCoincidentLocations(loc, locs);
 
 	//if (locs.GetSize() != 1)
 	//{
@@ -676,55 +1011,6 @@ void CedExporter::RecordLocations(const CePoint& p, CMapPtrToPtr& locIndex)
 	}
 }
 
-#ifdef _CEDIT
-#include "CeTile.h"
-#include "CeTileId.h"
-#include "CeTileData.h"
-#include "CeLocation.h"
-#endif
-
-// static
-void CedExporter::GetAllCoincidentLocations(const CeLocation* loc, CPtrArray& locs, FILE* log)
-{
-	//if (log != 0)
-	//{
-	//	fprintf(log, "before loop\n");
-	//	fflush(log);
-	//}
-
-	if (loc == 0)
-		return;
-	
-	const CeTileId& tileId = loc->GetTileID();
-	const CeTile* t = tileId.GetpTile();
-
-	for (const CeTileData* td = t->GetpTileData()->GetpTail(); td; td = td->GetpPrev())
-	{
-		int nLoc = (int)td->GetNumLoc();
-
-		//if (log != 0)
-		//{
-		//	fprintf(log, "nLoc=%d\n", nLoc);
-		//	fflush(log);
-		//}
-
-		const CeLocation** tLocs = td->GetpLocations();
-
-		for (int i=0; i<nLoc; i++)
-		{
-			const CeLocation* tLoc = tLocs[i];
-			if ((*loc) == (*tLoc))
-				locs.Add((void*)tLoc);
-		}
-	}
-
-	//if (log != 0)
-	//{
-	//	fprintf(log, "done loop nDup=%d\n", locs.GetSize());
-	//	fflush(log);
-	//}
-}
-
 void CedExporter::Log(LPCTSTR msg)
 {
 	if (LogFile != 0)
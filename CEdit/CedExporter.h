@@ -7,27 +7,53 @@ class CeMap;
 #include "CEditStubs.h"
 #endif
 
+#include "ExportOptions.h"
+
+class IEditWriter;
+class PtrIdTable;
+class OutputBuffer;
+class ExportState;
+class ExportStats;
+
 class CedExporter
 {
 public:
 	CedExporter();
+	CedExporter(const ExportOptions& options);
 	virtual ~CedExporter(void);
 	void CreateExport(CeMap* cedFile);
 
-	static void GetAllCoincidentLocations(const CeLocation* loc, CPtrArray& locs, FILE* log=0);
+	static IEditWriter* CreateEditWriter(ExportFormat format, OutputBuffer* output);
 
 private:
+	// How an attempt at an export turned out
+	enum ExportResult
+	{
+		ExportResult_Done,
+		ExportResult_Failed,	// The user has been told why
+		ExportResult_Restart,	// The previous export can't be carried on from, so do a full export
+	};
+
+	ExportResult RunExport(CeMap* cedFile, bool isFullExport);
+	void SupersedeProject(LPCTSTR projectFolder, LPCTSTR stateFileName, LPCTSTR indexFileName) const;
+	LPCTSTR GetEditFileExtension() const;
+	void AppendPeakMemory(CString& msg) const;
+	unsigned __int64 GetPeakMemory() const;
+	void WriteReport(ExportStats& stats, __int64 exportStart, LPCTSTR fileName, LPCTSTR mapName, LPCTSTR projectId, CString& summary) const;
+	void ExportAttributes(CeMap* cedFile, LPCTSTR projectFolder, LPCTSTR mapName);
 	void FillGuidString(CString& s) const;
 	void FillComputerName(CString& name) const;
+	bool ReadProjectId(LPCTSTR indexFileName, CString& guid) const;
+	bool CheckPreviousSessions(CeMap* cedFile, const ExportState& previous) const;
 	void AppendExportItems(const CTime& when, const CeOperation& op, IdFactory& idf, CPtrArray& exportItems);
-	void GenerateExtraPoints(CeMap* cedFile, IdFactory& idf, CPtrArray& points);
-	void CheckForExtraPoint(const CeLocation* loc, CMapPtrToPtr& locIndex, IdFactory& idf, CPtrArray& extraPoints);
-	void RecordLocations(const CePoint& p, CMapPtrToPtr& locIndex);
+	void GenerateExtraPoints(CeMap* cedFile, IdFactory& idf, CPtrArray& points, unsigned int firstSession);
+	void CheckForExtraPoint(const CeLocation* loc, PtrIdTable& locIndex, IdFactory& idf, CPtrArray& extraPoints);
+	void RecordLocations(const CePoint& p, IdFactory& idf, PtrIdTable& locIndex);
 	void Log(LPCTSTR msg);
 	void Log(const CString& msg);
 	void CleanObjectLists(CeMap* cedFile);
-	void LoadValidData(CMapPtrToPtr& validData, CeMap* cedFile);
 
 	FILE* LogFile;
+	ExportOptions m_Options;
 };
 
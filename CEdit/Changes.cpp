@@ -3,7 +3,11 @@
 #include "EditSerializer.h"
 #include "Features.h"
 #include "Changes.h"
+#include "ObjectScanner.h"
+#include "ExportState.h"
+#include "ExportStats.h"
 #include <assert.h>
+#include <typeinfo>
 
 #ifdef _CEDIT
 #include "CeArcExtension.h"
@@ -40,6 +44,10 @@
 #include "CeLeg.h"
 #include "CeExtraLeg.h"
 #include "CeOffsetPoint.h"
+#include "CeEntity.h"
+#include "CeIdManager.h"
+#include "CeIdHandle.h"
+#include "CeIdGroup.H"
 #else
 #include "CEditStubs.h"
 #endif
@@ -48,60 +56,23 @@
 
 
 IdFactory::IdFactory()
+	: m_ObjectIds(64*1024)
 {
 	m_MaxId = 0;
+	m_NumFeatureScanned = 0;
+	m_TrackStableKeys = false;
+	m_PreviousState = 0;
+	m_NumRestored = 0;
+	m_NumMismatched = 0;
+	m_NumEntityInfo = 0;
+	m_NumEntityInfoMiss = 0;
+	m_NumNameLookup = 0;
 
 	// Load translations from a specific location
-	LoadMappings("C:\\Backsight\\CEdit\\Entities.txt", m_EntityMap);
-	LoadMappings("C:\\Backsight\\CEdit\\Templates.txt", m_TemplateMap);
-	LoadMappings("C:\\Backsight\\CEdit\\IdGroups.txt", m_IdGroupMap);
-	LoadMappings("C:\\Backsight\\CEdit\\Schemas.txt", m_TableMap);
-}
-
-void IdFactory::LoadMappings(LPCTSTR fileName, CMapStringToPtr& index)
-{
-	FILE* fp = fopen(fileName,"r");
-	char buf[1024];
-
-	while ( fgets(buf,sizeof(buf),fp) )
-	{
-		// Grab the buffer into a CString, trim off any leading and trailing whitespace.
-		CString str(buf);
-		str.TrimLeft();
-		str.TrimRight();
-
-		// Skip blank records.
-		int nc = str.GetLength();
-		if ( nc==0 ) continue;
-
-		int eqpos = str.Find('=');
-		if (eqpos > 0)
-		{
-			CString ids = str.Left(eqpos);
-			ids.TrimLeft();
-			ids.TrimRight();
-
-			unsigned int id;
-			sscanf((LPCTSTR)ids, "%d", &id);
-			CString entName(str.Mid(eqpos+1));
-			entName.TrimLeft();
-			entName.TrimRight();
-
-			// I THINK that SetAt creates a new copy
-			index.SetAt(entName, (void*)id);
-		}
-	}
-
-	fclose(fp);
-}
-
-int IdFactory::LookupId(CMapStringToPtr& index, LPCTSTR name)
-{
-	void* result;
-	if (index.Lookup(name, result))
-		return (int)result;
-	else
-		return 0;
+	m_Entities.Load("C:\\Backsight\\CEdit\\Entities.txt");
+	m_Templates.Load("C:\\Backsight\\CEdit\\Templates.txt");
+	m_IdGroups.Load("C:\\Backsight\\CEdit\\IdGroups.txt");
+	m_Tables.Load("C:\\Backsight\\CEdit\\Schemas.txt");
 }
 
 unsigned int IdFactory::GetNextId(void* p)
@@ -121,7 +92,7 @@ unsigned int IdFactory::GetNextId(void* p)
 		unsigned int iid = FindId(p);
 		if (iid == 0)
 		{
-			m_ObjectIds.SetAt(p, (void*)m_MaxId);
+			m_ObjectIds.SetAt(p, m_MaxId);
 
 #ifdef _CEDIT
 			objectstore::touch(p, false);
@@ -142,21 +113,65 @@ unsigned int IdFactory::GetNextId(void* p)
 // to the same Backsight ID).
 void IdFactory::AddIndexEntry(void* p, unsigned int id)
 {
-	m_ObjectIds.SetAt(p, (void*)id);
+	m_ObjectIds.SetAt(p, id);
 }
 
 unsigned int IdFactory::FindId(void* p) const
 {
-	void* result;
+	unsigned int result;
 	if (m_ObjectIds.Lookup(p, result))
-		return (unsigned int)result;
+		return result;
 
 	return 0;
 }
 
 int IdFactory::GetEntityId(LPCTSTR entName)
 {
-	return LookupId(m_EntityMap, entName);
+	if (entName == 0)
+		return 0;
+
+	// If the name has been seen before, confirm that the string hasn't changed (a name
+	// that isn't in the table is looked up each time)
+	unsigned int index;
+	if (m_EntityNames.Lookup(entName, index) && strcmp(m_Entities.GetName(index), entName) == 0)
+		return m_Entities.GetId(index);
+
+	m_NumNameLookup++;
+	int i = m_Entities.Find(entName);
+	if (i < 0)
+		return 0;
+
+	m_EntityNames.SetAt(entName, (unsigned int)i);
+	return m_Entities.GetId(i);
+}
+
+// Returns the entity ID for a feature, along with whether its numeric keys have a check
+// digit. Both depend only on the feature's entity type, so they're worked out the first time
+// each entity type is seen (GetpWhat returns the name of the entity type), and remembered for
+// the rest of the export.
+EntityInfo IdFactory::GetEntityInfo(const CeFeature& f)
+{
+	EntityInfo result;
+	const CeEntity* ent = f.GetpEntity();
+	unsigned int packed;
+	m_NumEntityInfo++;
+
+	if (ent != 0 && m_EntityInfo.Lookup(ent, packed))
+	{
+		result.EntityId = (int)(packed >> 1);
+		result.HasCheckDigit = ((packed & 1) != 0);
+		return result;
+	}
+
+	m_NumEntityInfoMiss++;
+	result.EntityId = GetEntityId(f.GetpWhat());
+	CeIdGroup* group = (ent == 0 ? 0 : CeIdHandle::GetIdManager()->GetpGroup(ent));
+	result.HasCheckDigit = (group != 0 && group->HasCheckDigit());
+
+	if (ent != 0 && result.EntityId >= 0)
+		m_EntityInfo.SetAt(ent, ((unsigned int)result.EntityId << 1) | (result.HasCheckDigit ? 1 : 0));
+
+	return result;
 }
 
 int IdFactory::GetFontId(LPCTSTR fontTitle)
@@ -166,17 +181,34 @@ int IdFactory::GetFontId(LPCTSTR fontTitle)
 
 int IdFactory::GetTableId(LPCTSTR tableName)
 {
-	return LookupId(m_TableMap, tableName);
+	m_NumNameLookup++;
+	return m_Tables.Lookup(tableName);
 }
 
 int IdFactory::GetTemplateId(LPCTSTR templateName)
 {
-	return LookupId(m_TemplateMap, templateName);
+	m_NumNameLookup++;
+	return m_Templates.Lookup(templateName);
 }
 
 int IdFactory::GetGroupId(LPCTSTR groupName)
 {
-	return LookupId(m_IdGroupMap, groupName);
+	m_NumNameLookup++;
+	return m_IdGroups.Lookup(groupName);
+}
+
+// Records counts of what the factory has done (for the export report)
+void IdFactory::GetCounters(ExportStats& stats) const
+{
+	stats.SetCounter("FeaturesScanned", m_NumFeatureScanned);
+	stats.SetCounter("ObjectIds", m_ObjectIds.GetCount());
+	stats.SetCounter("LastId", m_MaxId);
+	stats.SetCounter("TilesIndexed", m_Locations.GetNumTile());
+	stats.SetCounter("LocationsIndexed", m_Locations.GetNumLoc());
+	stats.SetCounter("EntityLookups", m_NumEntityInfo);
+	stats.SetCounter("EntityLookupMisses", m_NumEntityInfoMiss);
+	stats.SetCounter("NameLookups", m_NumNameLookup);
+	stats.SetCounter("IdsRestored", m_NumRestored);
 }
 
 void IdFactory::WritePointsFile(LPCTSTR fileName)
@@ -185,7 +217,7 @@ void IdFactory::WritePointsFile(LPCTSTR fileName)
 
 	POSITION pos = m_ObjectIds.GetStartPosition();
 	void* key;
-	void* value;
+	unsigned int value;
 
 	while (pos)
 	{
@@ -207,86 +239,215 @@ void IdFactory::WritePointsFile(LPCTSTR fileName)
 
 void IdFactory::ClearOperationFeatureLists()
 {
-	POSITION pos = m_OpFeatures.GetStartPosition();
-	void* key;
-	void* value;
-
-	while(pos)
+	for (int i=0; i<m_EditFeatures.GetSize(); i++)
 	{
-		m_OpFeatures.GetNextAssoc(pos, key, value);
-		EditFeatures* edf = (EditFeatures*)value;
+		EditFeatures* edf = (EditFeatures*)m_EditFeatures.GetAt(i);
 		delete edf;
 	}
 
+	m_EditFeatures.RemoveAll();
 	m_OpFeatures.RemoveAll();
 }
 
-#ifdef _CEDIT
-#include "CeMap.h"
-#endif
-
+// Produces the lists of features created by each edit, using a scan of its own. When
+// other things also need to see every object in the CED file, it's better to include
+// the IdFactory in a shared ObjectScanner instead.
 void IdFactory::GenerateOperationFeatureLists(CeMap* cedFile)
 {
-#ifdef _CEDIT
-	ClearOperationFeatureLists();
+	ObjectScanner scanner(cedFile);
+	scanner.Add(this);
+	scanner.Run();
+}
+
+// Arranges for the next scan to note a stable key for every feature, so that the IDs
+// allocated by the export can be saved for use by a later export (see SaveState). If the
+// state saved by a previous export is supplied, the scan also restores the IDs it recorded
+// (and ID allocation carries on from where it finished). Restoring the IDs of locations
+// uses up the entries for them (see ExportState::TakeLocation). The state must remain in
+// scope until the scan has been run.
+void IdFactory::TrackStableKeys(ExportState* previous)
+{
+	m_TrackStableKeys = true;
+	m_PreviousState = previous;
+
+	if (previous != 0)
+		m_MaxId = previous->MaxId;
+}
+
+// Records the IDs that have been allocated against stable keys (features and locations are
+// the only things in a CED file that get IDs). TrackStableKeys must have been called before
+// the scan. Returns the number of IDs that could not be recorded (features that have no
+// creating edit).
+unsigned int IdFactory::SaveState(ExportState& state) const
+{
+	assert(m_TrackStableKeys);
+	state.MaxId = m_MaxId;
+	unsigned int numSkip = 0;
+
+	POSITION pos = m_ObjectIds.GetStartPosition();
+	void* key;
+	unsigned int id;
 
-	// Use an object cursor to go through everything.
-	void* ptr=0;
-	os_typespec* curts=0;
-	os_int32 count=0;
-	os_object_cursor c(os_database::of(cedFile));
+	while (pos)
+	{
+		m_ObjectIds.GetNextAssoc(pos, key, id);
+
+		unsigned int ordinal;
+		if (m_FeatureOrdinals.Lookup(key, ordinal))
+		{
+			const CeFeature* f = (const CeFeature*)key;
+			state.AddFeature(f->GetpCreator()->GetSequence(), ordinal, GetFeatureCheck(f), id);
+			continue;
+		}
+
+		const CeLocation* loc = dynamic_cast<const CeLocation*>((CeClass*)key);
+		if (loc != 0)
+			state.AddLocation(loc->GetEasting(), loc->GetNorthing(), id);
+		else
+			numSkip++;
+	}
+
+	return numSkip;
+}
+
+// Notes the stable key for a feature that has just been scanned, restoring any ID that was
+// previously recorded for it. The ID is only restored if the check value recorded with it
+// matches the feature (the order in which features get scanned could change, and the ordinal
+// would then lead to some other feature created by the same edit).
+void IdFactory::NoteStableKey(const CeFeature* f, const CeOperation* pop)
+{
+	unsigned int ordinal = 0;
+	m_OpFeatureCounts.Lookup(pop, ordinal);
+	m_OpFeatureCounts.SetAt(pop, ordinal+1);
+	m_FeatureOrdinals.SetAt(f, ordinal);
+
+	if (m_PreviousState != 0)
+	{
+		unsigned int id;
+		FeatureMatch match = m_PreviousState->MatchFeature(pop->GetSequence(), ordinal, GetFeatureCheck(f), id);
+
+		if (match == FeatureMatch_Same)
+		{
+			m_ObjectIds.SetAt(f, id);
+			m_NumRestored++;
+		}
+		else if (match == FeatureMatch_Different)
+			m_NumMismatched++;
+	}
+}
+
+// Returns a value that depends on the class of a feature, the name of its entity type, and
+// its key (if any). It's saved along with the feature's ID, and used to confirm that a
+// restored ID goes to the same feature. Features created by one edit are usually different
+// in at least one of these respects (e.g. the points and lines created by a path).
+unsigned int IdFactory::GetFeatureCheck(const CeFeature* f)
+{
+	LPCTSTR strings[3];
+	strings[0] = typeid(*f).name();
+	strings[1] = f->GetpWhat();
+	strings[2] = f->FormatKey();
+
+	// FNV-1a, with a zero byte after each string
+	unsigned int h = 2166136261u;
+
+	for (int i=0; i<3; i++)
+	{
+		for (LPCTSTR s = strings[i]; s != 0 && *s != '\0'; s++)
+			h = (h ^ (byte)*s) * 16777619u;
+
+		h = (h ^ 0) * 16777619u;
+	}
 
-	for ( c.first(); c.more(); c.next() )
+	return h;
+}
+
+// ObjectConsumer implementation
+void IdFactory::Start()
+{
+	ClearOperationFeatureLists();
+	m_NumFeatureScanned = 0;
+	m_FeatureOrdinals.RemoveAll();
+	m_OpFeatureCounts.RemoveAll();
+	m_NumRestored = 0;
+	m_NumMismatched = 0;
+}
+
+// ObjectConsumer implementation - if the object is a feature, add it to the list
+// for the edit that created it
+void IdFactory::Consume(void* ptr, int count)
+{
+#ifdef _CEDIT
+	try
 	{
-		if ( c.current(ptr,curts,count) )
+		CeClass* pc = (CeClass*)ptr;
+		objectstore::touch(pc, false);
+
+		const CeFeature* pFeat = dynamic_cast<const CeFeature*>(pc);
+		if (pFeat)
 		{
-			try
+			m_NumFeatureScanned++;
+			CeOperation* pop = pFeat->GetpCreator();
+			if (pop != 0 && m_TrackStableKeys)
+				NoteStableKey(pFeat, pop);
+
+			if (pop == 0)
 			{
-				CeClass* pc = (CeClass*)ptr;
-				objectstore::touch(pc, false);
+				int junk = 0;
+			}
+			else if (pop->GetType() != CEOP_SPLIT)
+			{
+				unsigned int index;
+				EditFeatures* pEditFeatures;
 
-				const CeFeature* pFeat = dynamic_cast<const CeFeature*>(pc);
-				if (pFeat)
+				if (m_OpFeatures.Lookup(pop, index))
 				{
-					CeOperation* pop = pFeat->GetpCreator();
-					if (pop == 0)
-					{
-						int junk = 0;
-					}
-					else if (pop->GetType() != CEOP_SPLIT)
-					{
-						void* p;
-						EditFeatures* pEditFeatures;
-
-						if (m_OpFeatures.Lookup((void*)pop, p))
-						{
-							pEditFeatures = (EditFeatures*)p;
-						}
-						else
-						{
-							pEditFeatures = new EditFeatures();
-							m_OpFeatures.SetAt((void*)pop, (void*)pEditFeatures);
-						}
-
-						pEditFeatures->Add(pFeat);
-					}
+					pEditFeatures = (EditFeatures*)m_EditFeatures.GetAt(index-1);
+				}
+				else
+				{
+					pEditFeatures = new EditFeatures();
+					m_OpFeatures.SetAt(pop, m_EditFeatures.Add(pEditFeatures)+1);
 				}
-			}
 
-			catch (...)
+				pEditFeatures->Add(pFeat);
+			}
+		}
+		else if (m_PreviousState != 0)
+		{
+			// Locations are the only other things that can have IDs to restore
+			const CeLocation* pLoc = dynamic_cast<const CeLocation*>(pc);
+			if (pLoc != 0)
 			{
+				unsigned int id = m_PreviousState->TakeLocation(pLoc->GetEasting(), pLoc->GetNorthing());
+				if (id != 0)
+				{
+					m_ObjectIds.SetAt(pLoc, id);
+					m_NumRestored++;
+				}
 			}
 		}
 	}
+
+	catch (...)
+	{
+	}
 #endif
 }
 
+// ObjectConsumer implementation
+void IdFactory::Finish()
+{
+	// Most of the IDs that get allocated will be for features, so make room
+	// for them now rather than growing the index as IDs get allocated
+	m_ObjectIds.Reserve(m_ObjectIds.GetCount() + m_NumFeatureScanned);
+}
+
 EditFeatures* IdFactory::FindFeatures(const CeOperation* pop) const
 {
-	void* value;
+	unsigned int index;
 
-	if (m_OpFeatures.Lookup((void*)pop, value))
-		return (EditFeatures*)value;
+	if (m_OpFeatures.Lookup(pop, index))
+		return (EditFeatures*)m_EditFeatures.GetAt(index-1);
 	else
 		return 0;
 }
@@ -1083,7 +1244,7 @@ LineSubdivisionOperation_c::LineSubdivisionOperation_c(IdFactory& idf, const CTi
 			unsigned int iid = idf.GetNextId(p);
 
 			// If the point has a user-perceived ID, remember the mapping
-			unsigned int rawId = Feature_c::GetRawId(*p);
+			unsigned int rawId = Feature_c::GetRawId(*p, idf.GetEntityInfo(*p).HasCheckDigit);
 			if (rawId != 0)
 			{
 				IdMapping_c* m = new IdMapping_c(iid, rawId);
@@ -1584,7 +1745,7 @@ void PathOperation_c::GetIdMappings(const CePath& op, const CeLeg& leg, CePoint*
 		if (p != 0)
 		{
 			// If the point has a user-perceived ID, remember the mapping
-			unsigned int rawId = Feature_c::GetRawId(*p);
+			unsigned int rawId = Feature_c::GetRawId(*p, idf.GetEntityInfo(*p).HasCheckDigit);
 			if (rawId != 0)
 			{
 				IdMapping_c* m = new IdMapping_c(iid, rawId);
@@ -3,6 +3,13 @@
 #include "Persistent.h"
 #include "Observations.h"
 #include "Features.h"
+#include "PtrIdTable.h"
+#include "LocationIndex.h"
+#include "ObjectScanner.h"
+#include "NameIdTable.h"
+
+class ExportState;
+class ExportStats;
 
 #ifdef _CEDIT
 class CeOperation;
@@ -44,7 +51,14 @@ class CeObjectList;
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-class IdFactory
+// What gets looked up for the entity type of each feature (see IdFactory::GetEntityInfo)
+struct EntityInfo
+{
+	int EntityId;			// The Backsight entity ID
+	bool HasCheckDigit;		// Do the numeric keys for the entity type end with a check digit?
+};
+
+class IdFactory : public ObjectConsumer
 {
 public:
 	IdFactory(void);
@@ -59,37 +73,101 @@ public:
 	unsigned int GetNextId(void* p);
 	unsigned int FindId(void* p) const;
 	void AddIndexEntry(void* p, unsigned int id);
+
+	// Obtains all locations that coincide with a location (including the location itself)
+	void GetCoincidentLocations(const CeLocation* loc, CPtrArray& locs)
+	{
+		m_Locations.GetCoincidentLocations(loc, locs);
+	}
+
 	void WritePointsFile(LPCTSTR fileName);
 	void GenerateOperationFeatureLists(CeMap* cedFile);
+	void Start();
+	void Consume(void* ptr, int count);
+	void Finish();
 	void ClearOperationFeatureLists();
 	EditFeatures* FindFeatures(const CeOperation* pop) const;
 	unsigned int FindFeatures(const CeOperation* pop, CeObjectList& result) const;
 
 	int GetEntityId(LPCTSTR entName);
+	EntityInfo GetEntityInfo(const CeFeature& f);
 	int GetFontId(LPCTSTR fontTitle);
 	int GetTableId(LPCTSTR tableName);
 	int GetTemplateId(LPCTSTR templateName);
 	int GetGroupId(LPCTSTR groupName);
 
+	void TrackStableKeys(ExportState* previous);
+	unsigned int SaveState(ExportState& state) const;
+	unsigned int GetNumRestored() const { return m_NumRestored; }
+	unsigned int GetNumMismatched() const { return m_NumMismatched; }
+	void GetCounters(ExportStats& stats) const;
+
 private:
-	void LoadMappings(LPCTSTR fileName, CMapStringToPtr& index);
-	int LookupId(CMapStringToPtr& index, LPCTSTR name);
+	void NoteStableKey(const CeFeature* f, const CeOperation* pop);
+	static unsigned int GetFeatureCheck(const CeFeature* f);
 
 private:
 	unsigned int m_MaxId;
 
+	// The number of features seen while generating the operation feature lists
+	unsigned int m_NumFeatureScanned;
+
 	// The key is a void pointer to some sort of persistent object in a ced file, the
 	// value is the Backsight internal ID
-	CMapPtrToPtr m_ObjectIds;
+	PtrIdTable m_ObjectIds;
+
+	// The key is a void pointer to an instance of CeOperation, the value is
+	// one more than the index of the corresponding element in m_EditFeatures.
+	PtrIdTable m_OpFeatures;
+
+	// Instances of EditFeatures (owned by this factory)
+	CPtrArray m_EditFeatures;
+
+	// Index of the locations in the CED file (used to find coincident locations)
+	LocationIndex m_Locations;
+
+	// Should the scan note the stable key for each feature (see ExportState)?
+	bool m_TrackStableKeys;
+
+	// When tracking stable keys, the key is a feature, and the value is its position among
+	// the features created by the same edit (in the order they were scanned)
+	PtrIdTable m_FeatureOrdinals;
+
+	// The number of features scanned so far for each edit (the key is a CeOperation)
+	PtrIdTable m_OpFeatureCounts;
+
+	// The state saved by a previous export (if the IDs it allocated are being restored)
+	ExportState* m_PreviousState;
+
+	// The number of IDs obtained from m_PreviousState
+	unsigned int m_NumRestored;
+
+	// The number of features whose key was found in m_PreviousState, but with a check value
+	// that no longer matches (meaning the saved IDs can't be trusted)
+	unsigned int m_NumMismatched;
+
+	// Translations from CEdit names to Backsight IDs
+	NameIdTable m_Entities;
+	NameIdTable m_Templates;
+	NameIdTable m_IdGroups;
+	NameIdTable m_Tables;
+
+	// Entity names that have been looked up. Features supply the name that belongs to their
+	// entity type, so the same few strings come up again and again. The key is the address of
+	// a name that has been looked up, and the value is the index of its entry in m_Entities.
+	PtrIdTable m_EntityNames;
+
+	// The entity types that have been seen by GetEntityInfo. The key is a CeEntity, and the
+	// value holds the entity ID (shifted up a bit), with the low bit set if the entity's
+	// numeric keys have a check digit.
+	PtrIdTable m_EntityInfo;
 
-	// The key is a void pointer to an instance of CeOperation, the value
-	// is a pointer to an instance of EditFeatures.
-	CMapPtrToPtr m_OpFeatures;
+	// The number of calls to GetEntityInfo, and how many of them weren't already known
+	unsigned int m_NumEntityInfo;
+	unsigned int m_NumEntityInfoMiss;
 
-	CMapStringToPtr m_EntityMap;
-	CMapStringToPtr m_TemplateMap;
-	CMapStringToPtr m_IdGroupMap;
-	CMapStringToPtr m_TableMap;
+	// The number of searches of the name tables
+	unsigned int m_NumNameLookup;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -118,7 +196,7 @@ protected:
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-class NewProjectEvent_c : Change_c
+class NewProjectEvent_c : public Change_c
 {
 public:
 	CString ProjectId;
@@ -0,0 +1,119 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include "CompressedOutputBuffer.h"
+
+#pragma comment(lib, "zlib.lib")
+
+CompressedOutputBuffer::CompressedOutputBuffer(FILE* fp, int level, unsigned int size)
+	: OutputBuffer(0, size)
+{
+	m_Target = fp;
+	m_CompressedSize = 256*1024;
+	m_Compressed = new byte[m_CompressedSize];
+	m_CompressedBytes = 0;
+	m_FrameOffset = 0;
+	m_FrameStart = 0;
+	m_NumFrames = 0;
+	m_CompressTicks = 0;
+	m_IsFrameStarted = false;
+
+	// Adding 16 to the window bits asks for a gzip header and trailer (rather than zlib's own)
+	memset(&m_Stream, 0, sizeof(m_Stream));
+	if (deflateInit2(&m_Stream, level, Z_DEFLATED, 15+16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		AfxThrowMemoryException();
+
+	m_IsOpen = true;
+}
+
+CompressedOutputBuffer::~CompressedOutputBuffer()
+{
+	Close();
+	delete [] m_Compressed;
+}
+
+// Compresses anything that is currently buffered (the compressor may hold on to some of it
+// until it has seen more, or until the end of the frame)
+void CompressedOutputBuffer::Flush()
+{
+	if (m_Length > 0 && m_IsOpen)
+	{
+		m_IsFrameStarted = true;
+		Compress(Z_NO_FLUSH);
+		m_Flushed += m_Length;
+		m_Length = 0;
+	}
+}
+
+// Completes the current frame, so that whatever follows goes into a new one
+void CompressedOutputBuffer::EndFrame()
+{
+	Flush();
+
+	if (m_IsFrameStarted)
+	{
+		Compress(Z_FINISH);
+		deflateReset(&m_Stream);
+		m_NumFrames++;
+		m_IsFrameStarted = false;
+		m_FrameOffset = m_CompressedBytes;
+		m_FrameStart = m_Flushed;
+	}
+}
+
+// Completes the last frame, and releases the compressor (the file is left open)
+void CompressedOutputBuffer::Close()
+{
+	if (m_IsOpen)
+	{
+		EndFrame();
+		deflateEnd(&m_Stream);
+		m_IsOpen = false;
+	}
+}
+
+// Compresses the whole buffer, before letting it grow if necessary
+void CompressedOutputBuffer::MakeRoom(unsigned int n)
+{
+	Flush();
+	OutputBuffer::MakeRoom(n);
+}
+
+// Passes the buffered data through the compressor, writing out whatever it produces
+void CompressedOutputBuffer::Compress(int flush)
+{
+	DWORD startTick = GetTickCount();
+
+	m_Stream.next_in = (Bytef*)m_Data;
+	m_Stream.avail_in = m_Length;
+
+	int status;
+	do
+	{
+		m_Stream.next_out = m_Compressed;
+		m_Stream.avail_out = m_CompressedSize;
+		status = deflate(&m_Stream, flush);
+		assert(status != Z_STREAM_ERROR);
+
+		unsigned int nOut = m_CompressedSize - m_Stream.avail_out;
+		if (nOut > 0)
+		{
+			fwrite(m_Compressed, 1, nOut, m_Target);
+			m_CompressedBytes += nOut;
+		}
+
+	} while (m_Stream.avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+
+	m_CompressTicks += (GetTickCount() - startTick);
+}
+
+// Describes the compression ratio and throughput
+void CompressedOutputBuffer::GetSummary(CString& s) const
+{
+	double mbIn = (double)GetTotalBytes() / (1024.0 * 1024.0);
+	double mbOut = (double)m_CompressedBytes / (1024.0 * 1024.0);
+	double ratio = (m_CompressedBytes > 0 ? (double)GetTotalBytes() / (double)m_CompressedBytes : 0.0);
+	double secs = (double)m_CompressTicks / 1000.0;
+
+	s.Format("Compressed %.1f MB to %.1f MB (%.1f:1) in %u frames, %u ms (%.1f MB/s)",
+		mbIn, mbOut, ratio, m_NumFrames, m_CompressTicks, (secs > 0.0 ? mbIn / secs : 0.0));
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <zlib.h>
+#include "OutputBuffer.h"
+
+// An output buffer that compresses its content on the way to the file. The output is a series
+// of gzip members (frames), each of which can be decompressed on its own. A reader that knows
+// where a frame starts can therefore begin there, without decompressing everything before it.
+// Tools that understand gzip treat the whole file as one stream (the members just follow on
+// from one another).
+//
+// The file must be opened in binary mode. It is not closed when the buffer is destroyed.
+class CompressedOutputBuffer : public OutputBuffer
+{
+public:
+	CompressedOutputBuffer(FILE* fp, int level, unsigned int size = DefaultSize);
+	virtual ~CompressedOutputBuffer();
+
+	virtual void Flush();
+	void EndFrame();
+	void Close();
+
+	// The number of compressed bytes written to the file (GetTotalBytes gives the number
+	// of bytes before compression)
+	unsigned __int64 GetCompressedBytes() const { return m_CompressedBytes; }
+
+	// Where the current frame starts in the file, and in the uncompressed data
+	unsigned __int64 GetFrameOffset() const { return m_FrameOffset; }
+	unsigned __int64 GetFrameStart() const { return m_FrameStart; }
+
+	unsigned int GetNumFrames() const { return m_NumFrames; }
+	DWORD GetCompressTicks() const { return m_CompressTicks; }
+	void GetSummary(CString& s) const;
+
+protected:
+	virtual void MakeRoom(unsigned int n);
+
+private:
+	void Compress(int flush);
+
+	FILE* m_Target;
+	z_stream m_Stream;
+	bool m_IsOpen;
+
+	// Does the current frame hold anything? (an empty frame is never written)
+	bool m_IsFrameStarted;
+
+	// Holds compressed data on its way to the file
+	byte* m_Compressed;
+	unsigned int m_CompressedSize;
+
+	unsigned __int64 m_CompressedBytes;
+	unsigned __int64 m_FrameOffset;
+	unsigned __int64 m_FrameStart;
+	unsigned int m_NumFrames;
+	DWORD m_CompressTicks;
+};
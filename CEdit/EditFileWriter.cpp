@@ -0,0 +1,250 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include "OutputBuffer.h"
+#include "MappedOutputBuffer.h"
+#include "CompressedOutputBuffer.h"
+#include "ExportIndex.h"
+#include "BinaryEditWriter.h"
+#include "NullEditWriter.h"
+#include "EditSerializer.h"
+#include "Changes.h"
+#include "CedExporter.h"
+#include "ParallelSerializer.h"
+#include "EditFileWriter.h"
+
+EditFileWriter::EditFileWriter(const IdFactory& idFactory, const ExportOptions& options)
+	: m_IdFactory(idFactory)
+	, m_Options(options)
+{
+	m_NumThread = ParallelSerializer::GetNumThread(options.NumWriterThreads);
+	m_File = 0;
+	m_Output = 0;
+	m_Compressed = 0;
+	m_Writer = 0;
+	m_Serializer = 0;
+	m_Parallel = 0;
+	m_Index = 0;
+	m_HasIndex = false;
+	m_NumItems = 0;
+	m_WriteTicks = 0;
+	m_NumFrameItems = 0;
+	m_NumObjects = 0;
+	m_NumValues = 0;
+	m_NumBytes = 0;
+}
+
+EditFileWriter::~EditFileWriter()
+{
+	Close();
+}
+
+// Opens the edit file (nothing gets opened if the null format has been requested). If the
+// export options ask for an index, it is written to the specified index file (if that can't
+// be created, the edit file is written without one). Returns false if the edit file could not
+// be created.
+bool EditFileWriter::Open(LPCTSTR fileName, LPCTSTR indexFileName)
+{
+	assert(m_Writer == 0);
+
+	if (m_Options.Format != ExportFormat_Null)
+	{
+		if (m_Options.CompressionLevel > 0)
+		{
+			m_File = fopen(fileName, "wb");
+			if (m_File == 0)
+				return false;
+
+			m_Compressed = new CompressedOutputBuffer(m_File, m_Options.CompressionLevel);
+			m_Output = m_Compressed;
+		}
+		else if (m_Options.MappedOutput)
+		{
+			MappedOutputBuffer* mapped = new MappedOutputBuffer(fileName);
+			if (!mapped->IsOpen())
+			{
+				delete mapped;
+				return false;
+			}
+
+			m_Output = mapped;
+		}
+		else
+		{
+			// A text-mode file would throw out the offsets in the index
+			bool isTextMode = (m_Options.Format == ExportFormat_Text && !m_Options.WriteIndex);
+			m_File = fopen(fileName, isTextMode ? "w" : "wb");
+			if (m_File == 0)
+				return false;
+
+			m_Output = new OutputBuffer(m_File);
+		}
+	}
+
+	m_Writer = CedExporter::CreateEditWriter(m_Options.Format, m_Output);
+	if (m_Options.Format == ExportFormat_Binary)
+		((BinaryEditWriter*)m_Writer)->WriteHeader();
+
+	m_Serializer = new EditSerializer(m_IdFactory, *m_Writer, m_Options.CompactLines);
+
+	// The worker threads are kept until the file is closed, rather than being started
+	// again for every batch
+	if (m_NumThread > 1 && m_Output != 0)
+		m_Parallel = new ParallelSerializer(m_IdFactory, m_Options, m_NumThread);
+
+	if (m_Options.WriteIndex && m_Output != 0 && indexFileName != 0)
+	{
+		m_Index = new ExportIndex(m_Options.ItemsPerIndexEntry);
+		m_HasIndex = m_Index->Open(indexFileName, m_Compressed);
+
+		if (!m_HasIndex)
+		{
+			delete m_Index;
+			m_Index = 0;
+			m_OutputSummary.Format("Cannot create index file %s", indexFileName);
+		}
+	}
+
+	return true;
+}
+
+// Writes out a batch of items, then deletes them (leaving the array empty). The items
+// must already have been allocated all their IDs.
+void EditFileWriter::WriteItems(CPtrArray& items)
+{
+	assert(m_Writer != 0);
+	DWORD startTick = GetTickCount();
+
+	// When compressing, write the batch in pieces that end where each frame should end
+	bool isFramed = (m_Compressed != 0 && m_Options.ItemsPerFrame > 0);
+	int start = 0;
+
+	while (start < items.GetSize())
+	{
+		int end = items.GetSize();
+		if (isFramed)
+			end = min(end, start + (int)(m_Options.ItemsPerFrame - m_NumFrameItems));
+
+		WriteRange(items, start, end);
+
+		if (isFramed)
+		{
+			m_NumFrameItems += (end - start);
+			if (m_NumFrameItems >= m_Options.ItemsPerFrame)
+			{
+				m_Compressed->EndFrame();
+				m_NumFrameItems = 0;
+			}
+		}
+
+		start = end;
+	}
+
+	m_WriteTicks += (GetTickCount() - startTick);
+	m_NumItems += items.GetSize();
+
+	for (int ip=0; ip<items.GetSize(); ip++)
+	{
+		Persistent_c* p = (Persistent_c*)items.GetAt(ip);
+		delete p;
+	}
+
+	items.RemoveAll();
+}
+
+// Formats a range of items (from start up to, but not including, end)
+void EditFileWriter::WriteRange(const CPtrArray& items, int start, int end)
+{
+	// Formatting one item doesn't depend on any other, so the work can be shared among
+	// several threads (the output is the same either way). It's not worth starting threads
+	// for a small batch though.
+	if (m_Parallel != 0 && end - start > ParallelSerializer::ChunkSize)
+	{
+		m_Parallel->Write(items, start, end, *m_Output, m_Index);
+	}
+	else
+	{
+		for (int ix=start; ix<end; ix++)
+		{
+			Persistent_c* p = (Persistent_c*)items.GetAt(ix);
+			if (m_Index != 0)
+				m_Index->AddItem(*p, m_Output->GetTotalBytes());
+
+			m_Serializer->WritePersistent(DataField_Edit, *p);
+		}
+	}
+}
+
+// Flushes anything that's still buffered, and closes the file
+void EditFileWriter::Close()
+{
+	if (m_Options.Format == ExportFormat_Null && m_Writer != 0)
+	{
+		NullEditWriter* nw = (NullEditWriter*)m_Writer;
+		m_NumObjects = nw->GetNumObjects();
+		m_NumValues = nw->GetNumValues();
+	}
+
+	if (m_Index != 0)
+	{
+		CString s;
+		s.Format("Index has %u entries", m_Index->GetNumEntries());
+		m_OutputSummary += s;
+
+		delete m_Index;
+		m_Index = 0;
+	}
+
+	if (m_Compressed != 0)
+	{
+		m_Compressed->Close();
+
+		CString s;
+		m_Compressed->GetSummary(s);
+		if (!m_OutputSummary.IsEmpty())
+			m_OutputSummary += "\n";
+		m_OutputSummary += s;
+		m_Compressed = 0;
+	}
+
+	delete m_Parallel;
+	m_Parallel = 0;
+
+	delete m_Serializer;
+	m_Serializer = 0;
+
+	delete m_Writer;
+	m_Writer = 0;
+
+	if (m_Output != 0)
+		m_NumBytes = m_Output->GetTotalBytes();
+
+	// Deleting a mapped buffer truncates the file to the length of the output
+	delete m_Output;
+	m_Output = 0;
+
+	if (m_File != 0)
+	{
+		fclose(m_File);
+		m_File = 0;
+	}
+}
+
+// Describes what has been written (call after Close, so that everything is accounted for)
+void EditFileWriter::GetSummary(CString& s) const
+{
+	if (m_Options.Format == ExportFormat_Null)
+	{
+		s.Format("Serialized %u items (%u objects, %u values) in %u ms",
+			m_NumItems, m_NumObjects, m_NumValues, m_WriteTicks);
+	}
+	else
+	{
+		s.Format("Wrote %u items in %u ms", m_NumItems, m_WriteTicks);
+	}
+
+	if (!m_OutputSummary.IsEmpty())
+	{
+		s += "\n";
+		s += m_OutputSummary;
+	}
+}
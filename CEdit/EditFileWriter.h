@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ExportOptions.h"
+
+class IdFactory;
+class IEditWriter;
+class OutputBuffer;
+class CompressedOutputBuffer;
+class EditSerializer;
+class ExportIndex;
+class ParallelSerializer;
+
+// Writes export items to an edit file, in the format specified by the export options. Items
+// can be written in batches (each batch is deleted once it has been written), which means the
+// export doesn't need to hold every item in memory at the same time.
+//
+// If the file is compressed, a new frame is started after every ExportOptions::ItemsPerFrame
+// items, so that a reader can start decompressing part way through the file.
+class EditFileWriter
+{
+public:
+	EditFileWriter(const IdFactory& idFactory, const ExportOptions& options);
+	~EditFileWriter();
+
+	bool Open(LPCTSTR fileName, LPCTSTR indexFileName = 0);
+	void WriteItems(CPtrArray& items);
+	void Close();
+
+	unsigned int GetNumItems() const { return m_NumItems; }
+	DWORD GetWriteTicks() const { return m_WriteTicks; }
+	unsigned __int64 GetNumBytes() const { return m_NumBytes; }
+	bool HasIndex() const { return m_HasIndex; }
+	void GetSummary(CString& s) const;
+
+private:
+	void WriteRange(const CPtrArray& items, int start, int end);
+
+	const IdFactory& m_IdFactory;
+	const ExportOptions& m_Options;
+	unsigned int m_NumThread;
+
+	FILE* m_File;
+	OutputBuffer* m_Output;
+	CompressedOutputBuffer* m_Compressed;	// Same as m_Output (if compressing)
+	IEditWriter* m_Writer;
+	EditSerializer* m_Serializer;
+	ParallelSerializer* m_Parallel;	// Null if items are formatted on this thread only
+	ExportIndex* m_Index;
+	bool m_HasIndex;	// Was the index file created (stays set after Close)
+
+	unsigned int m_NumItems;
+	DWORD m_WriteTicks;
+
+	// The number of items in the current compressed frame
+	unsigned int m_NumFrameItems;
+
+	// What was written, as recorded when the file was closed
+	unsigned int m_NumObjects;
+	unsigned int m_NumValues;
+	unsigned __int64 m_NumBytes;	// Before any compression
+	CString m_OutputSummary;
+};
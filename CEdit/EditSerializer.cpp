@@ -1,14 +1,38 @@
 #include "StdAfx.h"
 #include <assert.h>
+#include <math.h>
 #include "DataField.h"
-#include "TextEditWriter.h"
+#include "IEditWriter.h"
+#include "NumberFormatter.h"
+#include "LineStringCodec.h"
 #include "Features.h"
 #include "Changes.h"
 #include "EditSerializer.h"
 
-EditSerializer::EditSerializer(const IdFactory& idFactory, TextEditWriter& writer)
-	: m_IdFactory(idFactory), m_Writer(writer)
+EditSerializer::EditSerializer(const IdFactory& idFactory, IEditWriter& writer, bool compactLines)
+	: m_IdFactory(idFactory), m_Writer(writer), m_CompactLines(compactLines)
+{
+	m_Scratch = 0;
+	m_ScratchSize = 0;
+}
+
+EditSerializer::~EditSerializer(void)
+{
+	delete [] m_Scratch;
+}
+
+// Returns a buffer that can hold at least the specified number of characters. The
+// buffer remains valid until the next call.
+char* EditSerializer::GetScratch(unsigned int size)
 {
+	if (size > m_ScratchSize)
+	{
+		delete [] m_Scratch;
+		m_ScratchSize = max(size, 2 * m_ScratchSize);
+		m_Scratch = new char[m_ScratchSize];
+	}
+
+	return m_Scratch;
 }
 
 void EditSerializer::WritePersistentArray(DataField field, const CPtrArray& a)
@@ -16,52 +40,69 @@ void EditSerializer::WritePersistentArray(DataField field, const CPtrArray& a)
 	WriteBegin(field, 0);
 	WriteUInt32(DataField_Length, a.GetSize());
 
-	char itemName[16];
-
     for (int i=0; i<a.GetSize(); i++)
     {
-		sprintf(itemName, "[%d]", i);
 		const Persistent_c* const p = (const Persistent_c* const)a.GetAt(i);
-        WritePersistent(itemName, *p);
+        WritePersistent((unsigned int)i, *p);
     }
 
     WriteEnd();
 }
 
+// Writes the array as a string of values separated by semicolons
 void EditSerializer::WriteSimpleArray(DataField field, const CUIntArray& a)
 {
-	CString result;
-	char buf[16];
-
-	for (int i=0; i<a.GetSize(); i++)
-	{
-		unsigned int val = a.GetAt(i);
-		if (i > 0)
-			result += ";";
-
-		sprintf(buf, "%d", val);
-		result += buf;
-	}
-
-	WriteString(field, (LPCTSTR)result);
+	// Each value takes at most 11 characters, plus a separator (or the trailing null)
+	unsigned int n = (unsigned int)a.GetSize();
+	char* result = GetScratch(12 * n + 1);
+	result[NumberFormatter::FormatList(result, a.GetData(), n)] = '\0';
+	WriteString(field, result);
 }
 
+// Writes the array as a string of values separated by semicolons
 void EditSerializer::WriteByteArray(DataField field, __int8* data, unsigned int length)
 {
-	CString result;
-	char buf[8];
+	// Each value takes at most 4 characters, plus a separator (or the trailing null)
+	char* result = GetScratch(5 * length + 1);
+	result[NumberFormatter::FormatList(result, data, length)] = '\0';
+	WriteString(field, result);
+}
 
-	for (unsigned int i=0; i<length; i++)
+/// <summary>
+/// Writes the vertices of a line. Depending on how the serializer was set up, this is either
+/// a delta-encoded byte array (see <see cref="LineStringCodec"/>), or text of the form
+/// "x y,x y,..." (in meters).
+/// </summary>
+/// <param name="textField">The tag for the text form of the vertices</param>
+/// <param name="dataField">The tag for the encoded form of the vertices</param>
+/// <param name="xy">The positions of the vertices, in meters (X and Y alternate)</param>
+/// <param name="numVertex">The number of vertices</param>
+void EditSerializer::WriteLineString(DataField textField, DataField dataField, const double* xy, unsigned int numVertex)
+{
+	if (m_CompactLines)
 	{
-		__int8 val = data[i];
-		if (i > 0)
-			result += ";";
-
-		sprintf(buf, "%d", val);
-		result += buf;
+		// The microns and the encoded bytes share the scratch buffer (the microns go first,
+		// so they stay suitably aligned)
+		unsigned int micronSize = 2 * numVertex * sizeof(__int64);
+		char* scratch = GetScratch(micronSize + LineStringCodec::GetMaxLength(numVertex));
+		__int64* microns = (__int64*)scratch;
+		byte* data = (byte*)(scratch + micronSize);
+
+		// Express the positions in microns, rounding to the nearest one (a value that
+		// comes out a hair under a whole number of microns shouldn't lose that micron)
+		for (unsigned int i=0; i<2*numVertex; i++)
+			microns[i] = (__int64)floor(xy[i] * 1000000.0 + 0.5);
+
+		unsigned int len = LineStringCodec::Encode(data, microns, numVertex);
+		m_Writer.WriteBytes(dataField, data, len);
+	}
+	else
+	{
+		// Work out how much space is needed, so that the string can be built in one go
+		char* result = GetScratch(NumberFormatter::GetMaxLineStringLength(xy, numVertex) + 1);
+		result[NumberFormatter::FormatLineString(result, xy, numVertex)] = '\0';
+		m_Writer.WriteString(textField, result);
 	}
-
-	WriteString(field, (LPCTSTR)result);
 }
 
 /// <summary>
@@ -71,63 +112,10 @@ void EditSerializer::WriteByteArray(DataField field, __int8* data, unsigned int
 /// <param name="value">The radian value to write</param>
 void EditSerializer::WriteRadians(DataField field, double value, bool isDeflection)
 {
-	char buf[16];
-	RadiansAsShortString(buf, value, isDeflection);
-    m_Writer.WriteString(DataFields[field], buf);
-}
-
-#include <math.h>
-
-void EditSerializer::RadiansAsShortString(char* res, double value, bool isDeflection)
-{
-    // Convert to decimal degrees (possibly signed).
-    const double RADTODEG = 360.0 / (2.0 * 3.14159265358979323846);
-	double sdeg = value * RADTODEG;
-
-    // Get the degrees, minutes, and seconds, all unsigned.
-	double deg, mins, secs, rem;
-	double adeg = fabs(sdeg);
-    rem = modf(adeg, &deg);
-    rem = modf(rem*60.0, &mins);
-    secs = rem*60.0;
-
-    // Make sure we don't have max-values (i.e. 60's)
-	unsigned int ideg  = (unsigned int)(deg + 0.1);
-	unsigned int imins = (unsigned int)(mins + 0.1);
-
-	if (fabs(secs-60.0) < 0.001) // 3 decimals formatted below
-    {
-		secs -= 60.0;
-		secs = 0.0;
-		imins++;
-	}
-
-	if ( imins>=60 )
-    {
-		imins = 0;
-		ideg++;
-	}
-
-	// Normalize the degrees to be in the range [0,359]
-	while (ideg >= 360)
-		ideg -= 360;
-
-	// Create the return string, making sure that the sign is there.
-	if ( sdeg<0.0 )
-		sprintf(res, "-%d-%d", ideg, imins);
-	else
-		sprintf(res, "%d-%d", ideg, imins);
-
-	// Append seconds if they'll show.
-    if (secs>=0.001)
-	{
-		char extra[10];
-		sprintf(extra, "-%-.3f", secs);
-		strcat(res, extra);
-	}
-
-	if (isDeflection)
-		strcat(res, "d");
+	char buf[NumberFormatter::MaxLength+1];
+	unsigned int len = NumberFormatter::FormatRadians(buf, value, isDeflection);
+	buf[len] = '\0';
+    m_Writer.WriteString(field, buf);
 }
 
 /// <summary>
@@ -138,8 +126,8 @@ void EditSerializer::RadiansAsShortString(char* res, double value, bool isDeflec
 /// <param name="value">The position to write</param>
 void EditSerializer::WritePointGeometry(DataField xField, DataField yField, const PointGeometry_c& value)
 {
-    m_Writer.WriteInt64(DataFields[xField], value.X);
-    m_Writer.WriteInt64(DataFields[yField], value.Y);
+    m_Writer.WriteInt64(xField, value.X);
+    m_Writer.WriteInt64(yField, value.Y);
 }
 
 /// <summary>
@@ -149,7 +137,7 @@ void EditSerializer::WritePointGeometry(DataField xField, DataField yField, cons
 /// <param name="value">The unsigned byte to write.</param>
 void EditSerializer::WriteByte(DataField field, byte value)
 {
-    m_Writer.WriteByte(DataFields[field], value);
+    m_Writer.WriteByte(field, value);
 }
 
 /// <summary>
@@ -159,7 +147,7 @@ void EditSerializer::WriteByte(DataField field, byte value)
 /// <param name="value">The four-byte signed integer to write.</param>
 void EditSerializer::WriteInt32(DataField field, int value)
 {
-    m_Writer.WriteInt32(DataFields[field], value);
+    m_Writer.WriteInt32(field, value);
 }
 
 /// <summary>
@@ -169,7 +157,7 @@ void EditSerializer::WriteInt32(DataField field, int value)
 /// <param name="value">The four-byte unsigned integer to write.</param>
 void EditSerializer::WriteUInt32(DataField field, unsigned int value)
 {
-    m_Writer.WriteUInt32(DataFields[field], value);
+    m_Writer.WriteUInt32(field, value);
 }
 
 /// <summary>
@@ -179,7 +167,7 @@ void EditSerializer::WriteUInt32(DataField field, unsigned int value)
 /// <param name="value">The eight-byte signed integer to write.</param>
 void EditSerializer::WriteInt64(DataField field, __int64 value)
 {
-    m_Writer.WriteInt64(DataFields[field], value);
+    m_Writer.WriteInt64(field, value);
 }
 
 /// <summary>
@@ -189,7 +177,7 @@ void EditSerializer::WriteInt64(DataField field, __int64 value)
 /// <param name="value">The eight-byte floating-point value to write.</param>
 void EditSerializer::WriteDouble(DataField field, double value)
 {
-    m_Writer.WriteDouble(DataFields[field], value);
+    m_Writer.WriteDouble(field, value);
 }
 
 /// <summary>
@@ -199,7 +187,7 @@ void EditSerializer::WriteDouble(DataField field, double value)
 /// <param name="value">The four-byte floating-point value to write.</param>
 void EditSerializer::WriteSingle(DataField field, float value)
 {
-    m_Writer.WriteSingle(DataFields[field], value);
+    m_Writer.WriteSingle(field, value);
 }
 
 /// <summary>
@@ -209,7 +197,7 @@ void EditSerializer::WriteSingle(DataField field, float value)
 /// <param name="value">The boolean value to write (0 or 1).</param>
 void EditSerializer::WriteBool(DataField field, bool value)
 {
-    m_Writer.WriteBool(DataFields[field], value);
+    m_Writer.WriteBool(field, value);
 }
 
 /// <summary>
@@ -219,7 +207,7 @@ void EditSerializer::WriteBool(DataField field, bool value)
 /// <param name="value">The string to write (if a null is supplied, just the name tag will be written).</param>
 void EditSerializer::WriteString(DataField field, LPCTSTR value)
 {
-    m_Writer.WriteString(DataFields[field], value);
+    m_Writer.WriteString(field, value);
 }
 
 /// <summary>
@@ -229,7 +217,7 @@ void EditSerializer::WriteString(DataField field, LPCTSTR value)
 /// <param name="when">The timestamp to write</param>
 void EditSerializer::WriteDateTime(DataField field, const CTime& when)
 {
-    m_Writer.WriteDateTime(DataFields[field], when);
+    m_Writer.WriteDateTime(field, when);
 }
 
 /// <summary>
@@ -240,7 +228,7 @@ void EditSerializer::WriteDateTime(DataField field, const CTime& when)
 void EditSerializer::WriteInternalId(DataField field, unsigned int id)
 {
 	assert(id > 0);
-    m_Writer.WriteInternalId(DataFields[field], id);
+    m_Writer.WriteInternalId(field, id);
 }
 
 void EditSerializer::WriteFeatureRef(DataField field, void* feature)
@@ -251,7 +239,7 @@ void EditSerializer::WriteFeatureRef(DataField field, void* feature)
 		CeFeature* f = (CeFeature*)feature;
 		int junk = 0;
 	}
-	m_Writer.WriteInternalId(DataFields[field], iid);
+	m_Writer.WriteInternalId(field, iid);
 }
 
 void EditSerializer::WritePersistent(DataField field, const Persistent_c& p)
@@ -262,9 +250,9 @@ void EditSerializer::WritePersistent(DataField field, const Persistent_c& p)
 }
 
 // Private version for use with WritePersistentArray
-void EditSerializer::WritePersistent(LPCTSTR field, const Persistent_c& p)
+void EditSerializer::WritePersistent(unsigned int arrayIndex, const Persistent_c& p)
 {
-	m_Writer.WriteString(field, p.GetTypeName());
+	m_Writer.WriteArrayItem(arrayIndex, p.GetTypeName());
 	m_Writer.WriteBeginObject();
 	p.WriteData(*this);
 	WriteEnd();
@@ -272,7 +260,7 @@ void EditSerializer::WritePersistent(LPCTSTR field, const Persistent_c& p)
 
 void EditSerializer::WriteBegin(DataField field, LPCTSTR exportedTypeName)
 {
-	m_Writer.WriteString(DataFields[field], exportedTypeName);
+	m_Writer.WriteString(field, exportedTypeName);
 	m_Writer.WriteBeginObject();
 }
 
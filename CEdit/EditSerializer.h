@@ -2,7 +2,7 @@
 
 #include "DataField.h"
 
-class TextEditWriter;
+class IEditWriter;
 class Persistent_c;
 class PointGeometry_c;
 class IdFactory;
@@ -10,8 +10,8 @@ class IdFactory;
 class EditSerializer
 {
 public:
-	EditSerializer(const IdFactory& idFactory, TextEditWriter& writer);
-	~EditSerializer(void) {}
+	EditSerializer(const IdFactory& idFactory, IEditWriter& writer, bool compactLines = false);
+	~EditSerializer(void);
 
 	void WriteByte(DataField field, byte value);
 	void WriteInt32(DataField field, int value);
@@ -30,16 +30,22 @@ public:
 	void WritePersistentArray(DataField field, const CPtrArray& a);
 	void WriteSimpleArray(DataField field, const CUIntArray& a);
 	void WriteByteArray(DataField field, __int8* data, unsigned int length);
+	void WriteLineString(DataField textField, DataField dataField, const double* xy, unsigned int numVertex);
 
 private:
 	void WriteBegin(DataField field, LPCTSTR exportedTypeName);
 	void WriteEnd();
-	void RadiansAsShortString(char* buf, double value, bool isDeflection);
-	void WritePersistent(LPCTSTR field, const Persistent_c& p);
+	void WritePersistent(unsigned int arrayIndex, const Persistent_c& p);
+	char* GetScratch(unsigned int size);
 
 
 private:
-	TextEditWriter& m_Writer;
+	IEditWriter& m_Writer;
 	const IdFactory& m_IdFactory;
+	bool m_CompactLines;
+
+	// Space for building up long strings (reused from one call to the next)
+	char* m_Scratch;
+	unsigned int m_ScratchSize;
 };
 
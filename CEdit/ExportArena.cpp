@@ -0,0 +1,155 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ExportArena.h"
+
+// Every object is preceded by a header that says where it came from (kept to 8 bytes, so that
+// the object itself stays 8-byte aligned)
+union ObjectHeader
+{
+	unsigned int IsArena;
+	__int64 Align;
+};
+
+// Allocation sizes are rounded up to a multiple of this
+static const size_t Alignment = sizeof(ObjectHeader);
+
+ExportArena* ExportArena::s_Current = 0;
+
+ExportArena::ExportArena()
+{
+	m_Blocks = 0;
+	m_Next = m_End = 0;
+	m_InUse = 0;
+	m_NumAlloc = 0;
+	m_NumBytes = 0;
+	m_PeakBytes = 0;
+	m_NumBlock = 0;
+	m_NumReset = 0;
+
+	m_Previous = s_Current;
+	s_Current = this;
+}
+
+ExportArena::~ExportArena()
+{
+	assert(s_Current == this);
+	s_Current = m_Previous;
+
+	while (m_Blocks != 0)
+	{
+		Block* next = m_Blocks->Next;
+		free(m_Blocks);
+		m_Blocks = next;
+	}
+}
+
+// static
+void* ExportArena::AllocateObject(size_t size)
+{
+	size_t total = sizeof(ObjectHeader) + size;
+	ObjectHeader* h;
+
+	if (s_Current == 0)
+	{
+		h = (ObjectHeader*)malloc(total);
+		if (h == 0)
+			AfxThrowMemoryException();
+
+		h->IsArena = 0;
+	}
+	else
+	{
+		h = (ObjectHeader*)s_Current->Allocate(total);
+		h->IsArena = 1;
+	}
+
+	return h + 1;
+}
+
+// static
+void ExportArena::FreeObject(void* p)
+{
+	if (p == 0)
+		return;
+
+	// Anything in an arena gets released when the arena is reset
+	ObjectHeader* h = ((ObjectHeader*)p) - 1;
+	if (!h->IsArena)
+		free(h);
+}
+
+// static
+LPTSTR ExportArena::CopyString(LPCTSTR s)
+{
+	size_t n = strlen(s) + 1;
+	LPTSTR result = (LPTSTR)AllocateObject(n);
+	memcpy(result, s, n);
+	return result;
+}
+
+void* ExportArena::Allocate(size_t size)
+{
+	size = (size + Alignment - 1) & ~(Alignment - 1);
+
+	if ((size_t)(m_End - m_Next) < size)
+		AddBlock(size);
+
+	void* result = m_Next;
+	m_Next += size;
+
+	m_InUse += size;
+	if (m_InUse > m_PeakBytes)
+		m_PeakBytes = m_InUse;
+
+	m_NumAlloc++;
+	m_NumBytes += size;
+	return result;
+}
+
+// Starts a new block that has room for at least the specified number of bytes
+void ExportArena::AddBlock(size_t minSize)
+{
+	size_t size = (minSize > BlockSize ? minSize : BlockSize);
+	Block* b = (Block*)malloc(sizeof(Block) + size);
+	if (b == 0)
+		AfxThrowMemoryException();
+
+	b->Next = m_Blocks;
+	b->Size = size;
+	m_Blocks = b;
+	m_NumBlock++;
+
+	// The block header is a multiple of 8 bytes, so the space after it is suitably aligned
+	m_Next = (char*)(b + 1);
+	m_End = m_Next + size;
+}
+
+void ExportArena::Reset()
+{
+	// Hang on to the most recent block, since it will probably be needed again
+	if (m_Blocks != 0)
+	{
+		Block* b = m_Blocks->Next;
+		while (b != 0)
+		{
+			Block* next = b->Next;
+			free(b);
+			b = next;
+		}
+
+		m_Blocks->Next = 0;
+		m_Next = (char*)(m_Blocks + 1);
+		m_End = m_Next + m_Blocks->Size;
+	}
+
+	m_InUse = 0;
+	m_NumReset++;
+}
+
+void ExportArena::GetSummary(CString& s) const
+{
+	s.Format("Arena allocations=%u (%I64u KB, peak %u KB, %u blocks, %u resets)",
+		m_NumAlloc, m_NumBytes / 1024, (unsigned int)(m_PeakBytes / 1024), m_NumBlock, m_NumReset);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// A bump allocator for the objects that make up the export items. While an arena is current,
+// export objects are carved out of large blocks instead of coming from the heap one at a time.
+// Deleting an object from the arena does nothing (beyond running its destructor); the memory
+// is only given back when the arena is reset, which releases everything in one go.
+//
+// Objects allocated when no arena is current come from the heap as usual, so code that
+// creates export objects outside of an export doesn't need to know about the arena.
+//
+// The arena is not thread-safe. It's only used by the thread that generates the export items
+// (the threads that format the items never allocate export objects).
+class ExportArena
+{
+public:
+	// The size of each block obtained from the heap
+	static const unsigned int BlockSize = 1024*1024;
+
+	// Creating an arena makes it the current arena (until it is destroyed)
+	ExportArena();
+	~ExportArena();
+
+	// Allocates memory for an export object (from the current arena, if there is one)
+	static void* AllocateObject(size_t size);
+
+	// Releases memory obtained through AllocateObject
+	static void FreeObject(void* p);
+
+	// Makes a copy of a string (allocated like any other export object)
+	static LPTSTR CopyString(LPCTSTR s);
+
+	// Discards everything that has been allocated. Every object in the arena must have been
+	// deleted beforehand.
+	void Reset();
+
+	void GetSummary(CString& s) const;
+
+private:
+	struct Block
+	{
+		Block* Next;
+		size_t Size;
+	};
+
+	void* Allocate(size_t size);
+	void AddBlock(size_t minSize);
+
+	static ExportArena* s_Current;
+	ExportArena* m_Previous;
+
+	// The blocks obtained so far (most recent first)
+	Block* m_Blocks;
+
+	// The free space in the current block
+	char* m_Next;
+	char* m_End;
+
+	// The bytes allocated since the last reset
+	size_t m_InUse;
+
+	// Statistics for the life of the arena
+	unsigned int m_NumAlloc;
+	unsigned __int64 m_NumBytes;
+	size_t m_PeakBytes;
+	unsigned int m_NumBlock;
+	unsigned int m_NumReset;
+};
@@ -0,0 +1,76 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include "CompressedOutputBuffer.h"
+#include "Changes.h"
+#include "ExportIndex.h"
+
+ExportIndex::ExportIndex(unsigned int itemsPerEntry)
+{
+	m_File = 0;
+	m_Compressed = 0;
+	m_ItemsPerEntry = itemsPerEntry;
+	m_NumSkipped = 0;
+	m_NumEntries = 0;
+}
+
+ExportIndex::~ExportIndex()
+{
+	Close();
+}
+
+// Creates the index file. If the edit file is compressed, supply the buffer that does the
+// compression (the index needs to know where each frame starts).
+bool ExportIndex::Open(LPCTSTR fileName, CompressedOutputBuffer* compressed)
+{
+	assert(m_File == 0);
+	m_File = fopen(fileName, "w");
+	if (m_File == 0)
+		return false;
+
+	m_Compressed = compressed;
+	fputs("Sequence\tWhen\tOffset\tFileOffset\tSkip\tType\n", m_File);
+	return true;
+}
+
+// Notes an item that is about to be written (at the specified position in the edit
+// stream). Items must be supplied in the order they are written.
+void ExportIndex::AddItem(const Persistent_c& item, unsigned __int64 offset)
+{
+	if (m_File == 0)
+		return;
+
+	// Every item is a change of some sort (export items have always been instances of Change_c)
+	const Change_c* change = dynamic_cast<const Change_c*>(&item);
+	if (change == 0)
+		return;
+
+	bool isSessionEvent = (dynamic_cast<const NewSessionEvent_c*>(change) != 0 ||
+							dynamic_cast<const EndSessionEvent_c*>(change) != 0);
+
+	if (!isSessionEvent && ++m_NumSkipped < m_ItemsPerEntry)
+		return;
+
+	unsigned __int64 fileOffset = offset;
+	unsigned __int64 skip = 0;
+	if (m_Compressed != 0)
+	{
+		fileOffset = m_Compressed->GetFrameOffset();
+		skip = offset - m_Compressed->GetFrameStart();
+	}
+
+	CString when = change->When.Format("%Y-%m-%dT%H:%M:%S");
+	fprintf(m_File, "%u\t%s\t%I64u\t%I64u\t%I64u\t%s\n", change->Sequence, (LPCTSTR)when,
+		offset, fileOffset, skip, item.GetTypeName());
+
+	m_NumSkipped = 0;
+	m_NumEntries++;
+}
+
+void ExportIndex::Close()
+{
+	if (m_File != 0)
+	{
+		fclose(m_File);
+		m_File = 0;
+	}
+}
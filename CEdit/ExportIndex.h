@@ -0,0 +1,42 @@
+#pragma once
+
+class Persistent_c;
+class CompressedOutputBuffer;
+
+// Writes a sidecar index for an edit file. The index holds one line for the start and end
+// of each session, and for every Nth item in between, so that a reader can go straight to
+// a particular time or sequence number without parsing everything that comes before it.
+// Since each session can be parsed independently, the index also makes it possible to
+// divide up the parsing of a file.
+//
+// The index is a text file with one tab-separated line per entry (following a line that
+// names the columns):
+//
+//   Sequence	When	Offset	FileOffset	Skip	Type
+//
+// Offset is the position of the item in the edit stream. To reach the item, seek to
+// FileOffset in the file, then skip over the specified number of bytes. For an uncompressed
+// file, FileOffset is the same as Offset (and Skip is zero). For a compressed file, FileOffset
+// is the start of the frame that holds the item, and Skip is how far into the decompressed
+// frame the item starts.
+class ExportIndex
+{
+public:
+	ExportIndex(unsigned int itemsPerEntry);
+	~ExportIndex();
+
+	bool Open(LPCTSTR fileName, CompressedOutputBuffer* compressed);
+	void AddItem(const Persistent_c& item, unsigned __int64 offset);
+	void Close();
+
+	unsigned int GetNumEntries() const { return m_NumEntries; }
+
+private:
+	FILE* m_File;
+	CompressedOutputBuffer* m_Compressed;
+	unsigned int m_ItemsPerEntry;
+
+	// The number of items seen since the last entry
+	unsigned int m_NumSkipped;
+	unsigned int m_NumEntries;
+};
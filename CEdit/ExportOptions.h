@@ -0,0 +1,74 @@
+#pragma once
+
+// The different forms that an exported edit file can take
+enum ExportFormat
+{
+	ExportFormat_Text = 0,	// Lines of the form Name=value (written to <maxId>.txt)
+	ExportFormat_Binary,	// Tagged binary values (written to <maxId>.bin)
+	ExportFormat_Null		// Nothing gets written (for timing the rest of the export)
+};
+
+// Options that control how CedExporter produces its output
+class ExportOptions
+{
+public:
+	ExportOptions()
+		: Format(ExportFormat_Text)
+		, ValidateObjectLists(false)
+		, NumWriterThreads(1)
+		, Streaming(false)
+		, CompactLines(false)
+		, MappedOutput(false)
+		, CompressionLevel(0)
+		, ItemsPerFrame(1000)
+		, WriteIndex(false)
+		, ItemsPerIndexEntry(1000)
+		, Incremental(false)
+	{
+	}
+
+	// The format for the edit file
+	ExportFormat Format;
+
+	// Should object lists be checked for references to objects that aren't in the
+	// database? (done as part of the scan that generates the feature lists for each edit)
+	bool ValidateObjectLists;
+
+	// The number of threads to use when formatting the edit file (1 to do everything
+	// on the calling thread, 0 for one thread per processor)
+	unsigned int NumWriterThreads;
+
+	// Should the items for each session be written (and deleted) as soon as they have been
+	// generated? If not, all items are held in memory until everything has been generated.
+	bool Streaming;
+
+	// Should multi-segment lines be written as delta-encoded bytes (see LineStringCodec)?
+	// If not, each vertex is written as text in the LineString field.
+	bool CompactLines;
+
+	// Should the edit file be written through a memory-mapped view (see MappedOutputBuffer),
+	// rather than through stdio? Text written this way has "\n" line endings, not "\r\n".
+	bool MappedOutput;
+
+	// The level of gzip compression to apply to the edit file (0 for an uncompressed file,
+	// otherwise 1 to 9, as for zlib). A compressed file can't also be memory-mapped.
+	int CompressionLevel;
+
+	// The number of items in each independently decodable part of a compressed file
+	unsigned int ItemsPerFrame;
+
+	// Should a sidecar index be written alongside the edit file (see ExportIndex)? If so,
+	// an uncompressed text file is written with "\n" line endings (rather than "\r\n"), so
+	// that the offsets in the index match the file.
+	bool WriteIndex;
+
+	// The number of items between index entries (the start and end of each session always
+	// get an entry of their own)
+	unsigned int ItemsPerIndexEntry;
+
+	// Should the export be able to carry on from a previous export of the same map? If so,
+	// the export saves its state in the project folder (see ExportState). When the map has
+	// been exported before, only the sessions added since then get written (to a new edit
+	// file in the same project folder), using IDs that are consistent with the earlier files.
+	bool Incremental;
+};
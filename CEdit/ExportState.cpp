@@ -0,0 +1,351 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include "ExportState.h"
+
+// The first bytes of a state file
+static const char StateFileMagic[4] = { 'C', 'E', 'X', 'S' };
+
+// The version of the state file layout
+static const unsigned int StateFileVersion = 2;
+
+// The fixed-size part at the start of a state file
+struct StateFileHeader
+{
+	char Magic[4];
+	unsigned int Version;
+	unsigned int MaxId;
+	unsigned int NumSession;
+	__int64 LastSessionStart;
+	unsigned int LastSessionOps;
+	unsigned int NumRange;
+	unsigned int NumFeature;
+	unsigned int NumLocation;
+};
+
+ExportState::ExportState()
+{
+	MaxId = 0;
+	NumSession = 0;
+	LastSessionStart = 0;
+	LastSessionOps = 0;
+
+	m_Ranges = 0;
+	m_NumRange = m_MaxRange = 0;
+	m_Features = 0;
+	m_NumFeature = m_MaxFeature = 0;
+	m_Locations = 0;
+	m_NumLocation = m_MaxLocation = 0;
+	m_IsSorted = true;
+}
+
+ExportState::~ExportState()
+{
+	Clear();
+}
+
+void ExportState::Clear()
+{
+	free(m_Ranges);
+	m_Ranges = 0;
+	m_NumRange = m_MaxRange = 0;
+
+	free(m_Features);
+	m_Features = 0;
+	m_NumFeature = m_MaxFeature = 0;
+
+	free(m_Locations);
+	m_Locations = 0;
+	m_NumLocation = m_MaxLocation = 0;
+
+	m_IsSorted = true;
+}
+
+// Reads the state saved by a previous export, returning false if the file could not be read
+bool ExportState::Load(LPCTSTR fileName)
+{
+	Clear();
+
+	FILE* fp = fopen(fileName, "rb");
+	if (fp == 0)
+		return false;
+
+	// Get the length of the file, so that the counts in the header can be checked (a
+	// damaged header could otherwise ask for more memory than there is)
+	__int64 fileLength = -1;
+	if (_fseeki64(fp, 0, SEEK_END) == 0)
+	{
+		fileLength = _ftelli64(fp);
+		if (_fseeki64(fp, 0, SEEK_SET) != 0)
+			fileLength = -1;
+	}
+
+	StateFileHeader h;
+	bool ok = (fileLength >= 0 &&
+				fread(&h, sizeof(h), 1, fp) == 1 &&
+				memcmp(h.Magic, StateFileMagic, sizeof(h.Magic)) == 0 &&
+				h.Version == StateFileVersion);
+
+	if (ok)
+	{
+		unsigned __int64 expectedLength = sizeof(h) +
+										  (unsigned __int64)h.NumRange * sizeof(IdRange) +
+										  (unsigned __int64)h.NumFeature * sizeof(FeatureKey) +
+										  (unsigned __int64)h.NumLocation * sizeof(LocationKey);
+
+		ok = (expectedLength == (unsigned __int64)fileLength);
+	}
+
+	if (ok)
+	{
+		MaxId = h.MaxId;
+		NumSession = h.NumSession;
+		LastSessionStart = h.LastSessionStart;
+		LastSessionOps = h.LastSessionOps;
+
+		m_Ranges = (IdRange*)malloc(max(h.NumRange, 1u) * sizeof(IdRange));
+		m_Features = (FeatureKey*)malloc(max(h.NumFeature, 1u) * sizeof(FeatureKey));
+		m_Locations = (LocationKey*)malloc(max(h.NumLocation, 1u) * sizeof(LocationKey));
+		ok = (m_Ranges != 0 && m_Features != 0 && m_Locations != 0);
+	}
+
+	if (ok)
+	{
+		m_MaxRange = m_NumRange = h.NumRange;
+		m_MaxFeature = m_NumFeature = h.NumFeature;
+		m_MaxLocation = m_NumLocation = h.NumLocation;
+
+		ok = (fread(m_Ranges, sizeof(IdRange), m_NumRange, fp) == m_NumRange &&
+				fread(m_Features, sizeof(FeatureKey), m_NumFeature, fp) == m_NumFeature &&
+				fread(m_Locations, sizeof(LocationKey), m_NumLocation, fp) == m_NumLocation);
+	}
+
+	fclose(fp);
+
+	if (!ok)
+		Clear();
+
+	return ok;
+}
+
+// Writes out the state (sorting the keys if necessary), returning false if the file could
+// not be written
+bool ExportState::Save(LPCTSTR fileName)
+{
+	Sort();
+
+	FILE* fp = fopen(fileName, "wb");
+	if (fp == 0)
+		return false;
+
+	StateFileHeader h;
+	memcpy(h.Magic, StateFileMagic, sizeof(h.Magic));
+	h.Version = StateFileVersion;
+	h.MaxId = MaxId;
+	h.NumSession = NumSession;
+	h.LastSessionStart = LastSessionStart;
+	h.LastSessionOps = LastSessionOps;
+	h.NumRange = m_NumRange;
+	h.NumFeature = m_NumFeature;
+	h.NumLocation = m_NumLocation;
+
+	bool ok = (fwrite(&h, sizeof(h), 1, fp) == 1 &&
+				fwrite(m_Ranges, sizeof(IdRange), m_NumRange, fp) == m_NumRange &&
+				fwrite(m_Features, sizeof(FeatureKey), m_NumFeature, fp) == m_NumFeature &&
+				fwrite(m_Locations, sizeof(LocationKey), m_NumLocation, fp) == m_NumLocation);
+
+	if (fclose(fp) != 0)
+		ok = false;
+
+	return ok;
+}
+
+// Notes a range of IDs that has been written to an edit file (in an IdAllocation)
+void ExportState::AddIdRange(int groupId, unsigned int minId, unsigned int maxId)
+{
+	if (m_NumRange == m_MaxRange)
+	{
+		m_MaxRange = (m_MaxRange == 0 ? 64 : m_MaxRange*2);
+		m_Ranges = (IdRange*)realloc(m_Ranges, m_MaxRange * sizeof(IdRange));
+	}
+
+	IdRange& r = m_Ranges[m_NumRange++];
+	r.GroupId = groupId;
+	r.MinId = minId;
+	r.MaxId = maxId;
+}
+
+// Works out which parts of a range of IDs have not been written already (a range that has
+// been extended since it was written only needs its new IDs written). Each part is appended
+// to the array as a pair of values (the first and last ID in the part). There are never more
+// than a few hundred ranges, so this just looks through all of them.
+void ExportState::GetUnwrittenIdRanges(int groupId, unsigned int minId, unsigned int maxId, CUIntArray& parts) const
+{
+	// The first ID that hasn't been accounted for yet
+	unsigned __int64 next = minId;
+
+	while (next <= maxId)
+	{
+		// If a written range covers the next ID, skip past it. Otherwise the next part goes
+		// up to the start of the nearest written range after it (or the end of the range).
+		unsigned __int64 end = maxId;
+		bool isWritten = false;
+
+		for (unsigned int i=0; i<m_NumRange && !isWritten; i++)
+		{
+			const IdRange& r = m_Ranges[i];
+			if (r.GroupId != groupId)
+				continue;
+
+			if (r.MinId <= next && next <= r.MaxId)
+			{
+				next = (unsigned __int64)r.MaxId + 1;
+				isWritten = true;
+			}
+			else if (r.MinId > next && r.MinId <= end)
+				end = r.MinId - 1;
+		}
+
+		if (!isWritten)
+		{
+			parts.Add((unsigned int)next);
+			parts.Add((unsigned int)end);
+			next = end + 1;
+		}
+	}
+}
+
+// Records the ID for a feature (identified by the sequence number of the edit that created
+// it, and its position among the features created by that edit), along with a value that
+// can be used to check that the key still refers to the same feature
+void ExportState::AddFeature(unsigned int opSequence, unsigned int ordinal, unsigned int check, unsigned int id)
+{
+	if (m_NumFeature == m_MaxFeature)
+	{
+		m_MaxFeature = (m_MaxFeature == 0 ? 64*1024 : m_MaxFeature*2);
+		m_Features = (FeatureKey*)realloc(m_Features, m_MaxFeature * sizeof(FeatureKey));
+	}
+
+	FeatureKey& k = m_Features[m_NumFeature++];
+	k.Key = ((unsigned __int64)opSequence << 32) | ordinal;
+	k.Id = id;
+	k.Check = check;
+	m_IsSorted = false;
+}
+
+// Compares a feature with what was recorded for its key. The recorded ID is only returned
+// if the check value recorded with it is the same as the feature's (otherwise the ID is 0).
+FeatureMatch ExportState::MatchFeature(unsigned int opSequence, unsigned int ordinal, unsigned int check, unsigned int& id) const
+{
+	assert(m_IsSorted);
+	unsigned __int64 key = ((unsigned __int64)opSequence << 32) | ordinal;
+	unsigned int lo = 0;
+	unsigned int hi = m_NumFeature;
+
+	while (lo < hi)
+	{
+		unsigned int mid = lo + (hi - lo) / 2;
+		if (m_Features[mid].Key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	id = 0;
+	if (lo == m_NumFeature || m_Features[lo].Key != key)
+		return FeatureMatch_None;
+
+	if (m_Features[lo].Check != check)
+		return FeatureMatch_Different;
+
+	id = m_Features[lo].Id;
+	return FeatureMatch_Same;
+}
+
+// Records the ID for a location
+void ExportState::AddLocation(double easting, double northing, unsigned int id)
+{
+	if (m_NumLocation == m_MaxLocation)
+	{
+		m_MaxLocation = (m_MaxLocation == 0 ? 64*1024 : m_MaxLocation*2);
+		m_Locations = (LocationKey*)realloc(m_Locations, m_MaxLocation * sizeof(LocationKey));
+	}
+
+	LocationKey& k = m_Locations[m_NumLocation++];
+	k.X = GetMicrons(easting);
+	k.Y = GetMicrons(northing);
+	k.Id = id;
+	m_IsSorted = false;
+}
+
+// Returns an ID that was recorded for a location at the specified position (0 if there
+// isn't one). Coincident locations have an entry each, so every ID is only returned once
+// (the entry is cleared), and the next call for the same position gets the next ID.
+unsigned int ExportState::TakeLocation(double easting, double northing)
+{
+	assert(m_IsSorted);
+	// Coincident locations share the same key, so find the first entry for the position
+	// (the entries for a position are sorted by ID)
+	LocationKey key;
+	key.X = GetMicrons(easting);
+	key.Y = GetMicrons(northing);
+	key.Id = 0;
+	unsigned int lo = 0;
+	unsigned int hi = m_NumLocation;
+
+	while (lo < hi)
+	{
+		unsigned int mid = lo + (hi - lo) / 2;
+		if (CompareLocationKeys(&m_Locations[mid], &key) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	// Skip the entries that have already been taken (clearing them leaves the order intact,
+	// since cleared entries are always the first ones for their position)
+	for (; lo < m_NumLocation && m_Locations[lo].X == key.X && m_Locations[lo].Y == key.Y; lo++)
+	{
+		unsigned int id = m_Locations[lo].Id;
+		if (id != 0)
+		{
+			m_Locations[lo].Id = 0;
+			return id;
+		}
+	}
+
+	return 0;
+}
+
+// Sorts the keys, so that they can be searched
+void ExportState::Sort()
+{
+	if (m_IsSorted)
+		return;
+
+	qsort(m_Features, m_NumFeature, sizeof(FeatureKey), CompareFeatureKeys);
+	qsort(m_Locations, m_NumLocation, sizeof(LocationKey), CompareLocationKeys);
+	m_IsSorted = true;
+}
+
+// static
+int ExportState::CompareFeatureKeys(const void* a, const void* b)
+{
+	unsigned __int64 ka = ((const FeatureKey*)a)->Key;
+	unsigned __int64 kb = ((const FeatureKey*)b)->Key;
+	return (ka < kb ? -1 : (ka > kb ? 1 : 0));
+}
+
+// static
+int ExportState::CompareLocationKeys(const void* a, const void* b)
+{
+	const LocationKey* la = (const LocationKey*)a;
+	const LocationKey* lb = (const LocationKey*)b;
+
+	if (la->X != lb->X)
+		return (la->X < lb->X ? -1 : 1);
+
+	if (la->Y != lb->Y)
+		return (la->Y < lb->Y ? -1 : 1);
+
+	return (la->Id < lb->Id ? -1 : (la->Id > lb->Id ? 1 : 0));
+}
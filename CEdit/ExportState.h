@@ -0,0 +1,115 @@
+#pragma once
+
+#include <math.h>
+
+// How a feature compares with what a previous export recorded for its key
+enum FeatureMatch
+{
+	FeatureMatch_None,			// Nothing was recorded for the key
+	FeatureMatch_Same,			// The recorded ID belongs to the feature
+	FeatureMatch_Different,		// The key was recorded for some other feature
+};
+
+// What an export needs to remember so that a later export of the same map can carry on
+// from where it finished (see ExportOptions::Incremental). This covers the ID that was
+// allocated last, the sessions and ID ranges that have been written, and the internal IDs
+// that were given to objects in the CED file.
+//
+// The addresses of objects in a CED file are no good for identifying them in a later run,
+// so IDs are recorded against stable keys instead (see IdFactory::SaveState):
+//
+//  - A feature is identified by the sequence number of the edit that created it, along with
+//    its position among the features created by that edit (in the order the database gets
+//    scanned). Nothing guarantees that the scan order stays the same, so a check value
+//    (derived from the feature's type, entity type, and key) is saved alongside. An ID is
+//    only restored if the check value still matches (see MatchFeature).
+//
+//  - A location is identified by its position (in microns). Distinct locations can share a
+//    position, so there may be several entries for one position. Each of those IDs gets
+//    handed out once when they are restored (see TakeLocation).
+//
+// The state is held in a binary file with a fixed-size header, followed by the ID ranges,
+// the feature keys, and the location keys. The keys are held in sorted order, so they can be
+// searched once they have been loaded.
+class ExportState
+{
+public:
+	ExportState();
+	~ExportState();
+
+	bool Load(LPCTSTR fileName);
+	bool Save(LPCTSTR fileName);
+
+	void AddIdRange(int groupId, unsigned int minId, unsigned int maxId);
+	void GetUnwrittenIdRanges(int groupId, unsigned int minId, unsigned int maxId, CUIntArray& parts) const;
+
+	void AddFeature(unsigned int opSequence, unsigned int ordinal, unsigned int check, unsigned int id);
+	FeatureMatch MatchFeature(unsigned int opSequence, unsigned int ordinal, unsigned int check, unsigned int& id) const;
+
+	void AddLocation(double easting, double northing, unsigned int id);
+	unsigned int TakeLocation(double easting, double northing);
+
+	void Sort();
+
+	unsigned int GetNumFeature() const { return m_NumFeature; }
+	unsigned int GetNumLocation() const { return m_NumLocation; }
+
+	// The last ID that was allocated
+	unsigned int MaxId;
+
+	// The number of sessions in the CED file that have been exported
+	unsigned int NumSession;
+
+	// The start time, and the number of edits, for the last session that was exported (used
+	// to confirm that the sessions have not changed since then)
+	__int64 LastSessionStart;
+	unsigned int LastSessionOps;
+
+private:
+	struct IdRange
+	{
+		int GroupId;
+		unsigned int MinId;
+		unsigned int MaxId;
+	};
+
+	struct FeatureKey
+	{
+		unsigned __int64 Key;		// The edit sequence in the high 32 bits, the ordinal in the low 32
+		unsigned int Id;
+		unsigned int Check;			// See IdFactory::GetFeatureCheck
+	};
+
+	struct LocationKey
+	{
+		__int64 X;
+		__int64 Y;
+		unsigned int Id;
+	};
+
+	static __int64 GetMicrons(double v)
+	{
+		return (__int64)floor(v * 1000000.0 + 0.5);
+	}
+
+	static int CompareFeatureKeys(const void* a, const void* b);
+	static int CompareLocationKeys(const void* a, const void* b);
+
+	void Clear();
+
+	IdRange* m_Ranges;
+	unsigned int m_NumRange;
+	unsigned int m_MaxRange;
+
+	FeatureKey* m_Features;
+	unsigned int m_NumFeature;
+	unsigned int m_MaxFeature;
+
+	LocationKey* m_Locations;
+	unsigned int m_NumLocation;
+	unsigned int m_MaxLocation;
+
+	// Have the keys been sorted since the last one was added? (they need to be sorted
+	// before they can be searched)
+	bool m_IsSorted;
+};
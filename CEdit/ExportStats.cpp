@@ -0,0 +1,268 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include "ExportOptions.h"
+#include "ExportStats.h"
+
+ExportStats::ExportStats()
+{
+	LARGE_INTEGER f;
+	QueryPerformanceFrequency(&f);
+	m_Frequency = f.QuadPart;
+
+	m_NumPhase = 0;
+	m_NumCounter = 0;
+	memset(m_Ops, 0, sizeof(m_Ops));
+}
+
+// Adds the time since startTime (a value obtained from Now) to a phase of the export
+void ExportStats::AddPhase(LPCTSTR name, __int64 startTime)
+{
+	__int64 ticks = Now() - startTime;
+
+	for (unsigned int i=0; i<m_NumPhase; i++)
+	{
+		if (strcmp(m_Phases[i].Name, name) == 0)
+		{
+			m_Phases[i].Ticks += ticks;
+			m_Phases[i].Count++;
+			return;
+		}
+	}
+
+	assert(m_NumPhase < MaxPhase);
+	if (m_NumPhase < MaxPhase)
+	{
+		Phase& p = m_Phases[m_NumPhase++];
+		p.Name = name;
+		p.Ticks = ticks;
+		p.Count = 1;
+	}
+}
+
+// Records the time since startTime (a value obtained from Now) as the cost of constructing
+// the export items for an edit of the specified type
+void ExportStats::AddOperation(int opType, unsigned int numItems, __int64 startTime)
+{
+	__int64 ticks = Now() - startTime;
+
+	if (opType < 0 || opType >= (int)MaxOpType)
+		return;
+
+	OpCost& op = m_Ops[opType];
+	op.Count++;
+	op.NumItems += numItems;
+	op.Ticks += ticks;
+
+	__int64 micros = (ticks * 1000000) / m_Frequency;
+	unsigned int b = 0;
+	while (micros > 0 && b+1 < NumCostBuckets)
+	{
+		micros >>= 1;
+		b++;
+	}
+
+	op.Buckets[b]++;
+}
+
+// Records the value of a counter (replacing any value previously recorded for it)
+void ExportStats::SetCounter(LPCTSTR name, unsigned __int64 value)
+{
+	for (unsigned int i=0; i<m_NumCounter; i++)
+	{
+		if (strcmp(m_Counters[i].Name, name) == 0)
+		{
+			m_Counters[i].Value = value;
+			return;
+		}
+	}
+
+	assert(m_NumCounter < MaxCounter);
+	if (m_NumCounter < MaxCounter)
+	{
+		Counter& c = m_Counters[m_NumCounter++];
+		c.Name = name;
+		c.Value = value;
+	}
+}
+
+// Returns the total time recorded for a phase (0 if the phase hasn't been recorded)
+double ExportStats::GetPhaseMs(LPCTSTR name) const
+{
+	for (unsigned int i=0; i<m_NumPhase; i++)
+	{
+		if (strcmp(m_Phases[i].Name, name) == 0)
+			return GetMs(m_Phases[i].Ticks);
+	}
+
+	return 0.0;
+}
+
+// Describes the time taken by each phase (one line per phase)
+void ExportStats::GetSummary(CString& s) const
+{
+	s.Empty();
+
+	for (unsigned int i=0; i<m_NumPhase; i++)
+	{
+		CString line;
+		line.Format("%s%s=%.0f ms", (i == 0 ? "" : "\n"), m_Phases[i].Name, GetMs(m_Phases[i].Ticks));
+		s += line;
+	}
+}
+
+// Writes everything that has been recorded to a JSON file, returning false if the file
+// could not be created
+bool ExportStats::WriteReport(LPCTSTR fileName, LPCTSTR mapName, LPCTSTR projectId, const ExportOptions& options) const
+{
+	FILE* fp = fopen(fileName, "w");
+	if (fp == 0)
+		return false;
+
+	CString when = CTime::GetCurrentTime().Format("%Y-%m-%dT%H:%M:%S");
+
+	fputs("{\n  \"Version\": 1,\n  \"Map\": ", fp);
+	WriteString(fp, mapName);
+	fputs(",\n  \"ProjectId\": ", fp);
+	WriteString(fp, projectId);
+	fprintf(fp, ",\n  \"When\": \"%s\",\n", (LPCTSTR)when);
+
+	fprintf(fp, "  \"Options\": { \"Format\": %d, \"NumWriterThreads\": %u, \"Streaming\": %s, \"CompactLines\": %s, "
+				"\"MappedOutput\": %s, \"CompressionLevel\": %d, \"WriteIndex\": %s, \"Incremental\": %s },\n",
+				(int)options.Format, options.NumWriterThreads,
+				(options.Streaming ? "true" : "false"),
+				(options.CompactLines ? "true" : "false"),
+				(options.MappedOutput ? "true" : "false"),
+				options.CompressionLevel,
+				(options.WriteIndex ? "true" : "false"),
+				(options.Incremental ? "true" : "false"));
+
+	fputs("  \"Phases\": [", fp);
+	for (unsigned int i=0; i<m_NumPhase; i++)
+	{
+		const Phase& p = m_Phases[i];
+		fprintf(fp, "%s\n    { \"Name\": ", (i == 0 ? "" : ","));
+		WriteString(fp, p.Name);
+		fprintf(fp, ", \"Ms\": %.3f, \"Count\": %u }", GetMs(p.Ticks), p.Count);
+	}
+	fputs("\n  ],\n", fp);
+
+	fputs("  \"Counters\": {", fp);
+	for (unsigned int i=0; i<m_NumCounter; i++)
+	{
+		fprintf(fp, "%s\n    ", (i == 0 ? "" : ","));
+		WriteString(fp, m_Counters[i].Name);
+		fprintf(fp, ": %I64u", m_Counters[i].Value);
+	}
+	fputs("\n  },\n", fp);
+
+	// Histogram buckets are reported as the upper limit of each bucket, in microseconds
+	// (the last bucket has no limit)
+	fputs("  \"CostBucketLimits\": [", fp);
+	for (unsigned int b=0; b+1<NumCostBuckets; b++)
+		fprintf(fp, "%s%u", (b == 0 ? "" : ", "), (1u << b));
+	fputs(", null],\n", fp);
+
+	fputs("  \"Operations\": [", fp);
+	bool isFirst = true;
+	for (int t=0; t<(int)MaxOpType; t++)
+	{
+		const OpCost& op = m_Ops[t];
+		if (op.Count == 0)
+			continue;
+
+		fprintf(fp, "%s\n    { \"Type\": %d, \"Name\": \"%s\", \"Count\": %u, \"Items\": %u, \"Ms\": %.3f, \"Histogram\": [",
+			(isFirst ? "" : ","), t, GetOpTypeName(t), op.Count, op.NumItems, GetMs(op.Ticks));
+
+		// Leave out the empty buckets at the end
+		unsigned int nb = NumCostBuckets;
+		while (nb > 1 && op.Buckets[nb-1] == 0)
+			nb--;
+
+		for (unsigned int b=0; b<nb; b++)
+			fprintf(fp, "%s%u", (b == 0 ? "" : ", "), op.Buckets[b]);
+
+		fputs("] }", fp);
+		isFirst = false;
+	}
+	fputs("\n  ]\n}\n", fp);
+
+	return (fclose(fp) == 0);
+}
+
+// Writes a string as a JSON value (in quotes, with any special characters escaped)
+// static
+void ExportStats::WriteString(FILE* fp, LPCTSTR s)
+{
+	fputc('"', fp);
+
+	for (; s != 0 && *s != 0; s++)
+	{
+		unsigned char c = (unsigned char)*s;
+		if (c == '"' || c == '\\')
+		{
+			fputc('\\', fp);
+			fputc(c, fp);
+		}
+		else if (c < 0x20)
+			fprintf(fp, "\\u%04x", c);
+		else
+			fputc(c, fp);
+	}
+
+	fputc('"', fp);
+}
+
+// Returns the name of a CEOP value
+// static
+LPCTSTR ExportStats::GetOpTypeName(int opType)
+{
+	static LPCTSTR names[] =
+	{
+		"CEOP_NULL",
+		"CEOP_DATA_IMPORT",
+		"CEOP_ARC_SUBDIVISION",
+		"CEOP_ANNOTATION",
+		"CEOP_LINE_INTERSECTION",
+		"CEOP_NETWORK",
+		"CEOP_RADIAL_STAKEOUT",
+		"CEOP_EXTENSION",
+		"CEOP_BANK_TRAVERSE",
+		"CEOP_CLOSED_TRAVERSE",
+		"CEOP_OPEN_TRAVERSE",
+		"CEOP_PARALLEL_TRAVERSE",
+		"CEOP_DIR_INTERSECT",
+		"CEOP_DIST_INTERSECT",
+		"CEOP_DIRDIST_INTERSECT",
+		"CEOP_NEW_POINT",
+		"CEOP_NEW_LABEL",
+		"CEOP_MOVE_LABEL",
+		"CEOP_DELETION",
+		"CEOP_UPDATE",
+		"CEOP_NEW_ARC",
+		"CEOP_PATH",
+		"CEOP_SPLIT",
+		"CEOP_AREA_SUBDIVISION",
+		"CEOP_SET_LABEL_ROTATION",
+		"CEOP_GET_BACKGROUND",
+		"CEOP_TRUNCATE",
+		"CEOP_GET_CONTROL",
+		"CEOP_ARC_CLIP",
+		"CEOP_ARC_SPLIT",
+		"CEOP_NEW_CIRCLE",
+		"CEOP_LINE_INTERSECT",
+		"CEOP_DIRLINE_INTERSECT",
+		"CEOP_ARC_EXTEND",
+		"CEOP_RADIAL",
+		"CEOP_SET_THEME",
+		"CEOP_SET_TOPOLOGY",
+		"CEOP_POINT_ON_LINE",
+		"CEOP_PARALLEL",
+		"CEOP_TRIM",
+		"CEOP_ATTACH_POINT"
+	};
+
+	if (opType >= 0 && opType < (int)(sizeof(names) / sizeof(names[0])))
+		return names[opType];
+
+	return "Unknown";
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+class ExportOptions;
+
+// Timings and counters collected during an export, so that the cost of each part of the
+// export can be compared from one version of the exporter to the next. The results can be
+// written as a JSON report (see WriteReport).
+//
+// Times come from the performance counter. A phase can be timed in several pieces (e.g. when
+// streaming, the items get written a session at a time), in which case the times are added up.
+// The cost of constructing the export items is also broken down by the type of edit (the CEOP
+// value), with a histogram of the time taken for each edit.
+class ExportStats
+{
+public:
+	// The number of buckets in each histogram. Bucket 0 is for edits that took less than a
+	// microsecond; bucket i is for edits that took at least 2^(i-1) microseconds, but less than
+	// 2^i (the last bucket also takes anything longer).
+	static const unsigned int NumCostBuckets = 24;
+
+	// One more than the largest CEOP value that can be recorded
+	static const unsigned int MaxOpType = 64;
+
+	ExportStats();
+
+	// The current value of the performance counter (pass it to AddPhase or AddOperation
+	// once the thing being timed is done)
+	static __int64 Now()
+	{
+		LARGE_INTEGER t;
+		QueryPerformanceCounter(&t);
+		return t.QuadPart;
+	}
+
+	void AddPhase(LPCTSTR name, __int64 startTime);
+	void AddOperation(int opType, unsigned int numItems, __int64 startTime);
+	void SetCounter(LPCTSTR name, unsigned __int64 value);
+
+	double GetPhaseMs(LPCTSTR name) const;
+	void GetSummary(CString& s) const;
+	bool WriteReport(LPCTSTR fileName, LPCTSTR mapName, LPCTSTR projectId, const ExportOptions& options) const;
+
+private:
+	static const unsigned int MaxPhase = 32;
+	static const unsigned int MaxCounter = 32;
+
+	struct Phase
+	{
+		LPCTSTR Name;
+		__int64 Ticks;
+		unsigned int Count;		// The number of pieces the phase was timed in
+	};
+
+	struct Counter
+	{
+		LPCTSTR Name;
+		unsigned __int64 Value;
+	};
+
+	struct OpCost
+	{
+		unsigned int Count;
+		unsigned int NumItems;
+		__int64 Ticks;
+		unsigned int Buckets[NumCostBuckets];
+	};
+
+	double GetMs(__int64 ticks) const { return (double)ticks * 1000.0 / (double)m_Frequency; }
+	static LPCTSTR GetOpTypeName(int opType);
+	static void WriteString(FILE* fp, LPCTSTR s);
+
+	__int64 m_Frequency;
+
+	// Phases and counters are reported in the order they were first added. The names must
+	// remain in scope (they're expected to be literals).
+	Phase m_Phases[MaxPhase];
+	unsigned int m_NumPhase;
+	Counter m_Counters[MaxCounter];
+	unsigned int m_NumCounter;
+
+	// Construction costs, indexed by CEOP value
+	OpCost m_Ops[MaxOpType];
+};
@@ -98,12 +98,12 @@ FeatureId_c::FeatureId_c(unsigned int nativeRawId)
 FeatureId_c::FeatureId_c(LPCTSTR foreignId)
 {
 	NativeId = 0;
-	ForeignId = new CString(foreignId);
+	ForeignId = ExportArena::CopyString(foreignId);
 }
 
 FeatureId_c::~FeatureId_c()
 {
-	delete ForeignId;
+	ExportArena::FreeObject(ForeignId);
 }
 
 LPCTSTR FeatureId_c::GetTypeName() const
@@ -117,7 +117,7 @@ void FeatureId_c::WriteData(EditSerializer& s) const
 	if (NativeId > 0)
 		s.WriteUInt32(DataField_Key, NativeId);
 	else
-		s.WriteString(DataField_ForeignKey, (LPCTSTR)(*ForeignId));
+		s.WriteString(DataField_ForeignKey, ForeignId);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -125,14 +125,15 @@ void FeatureId_c::WriteData(EditSerializer& s) const
 FeatureStub_c::FeatureStub_c(IdFactory& idf, const CeFeature& f)
 {
 	InternalId = idf.GetNextId((void*)&f);
-	EntityId = idf.GetEntityId(f.GetpWhat());
+	EntityInfo ent = idf.GetEntityInfo(f);
+	EntityId = (unsigned int)ent.EntityId;
 
 	CeFeatureId* pFid = f.GetpId();
 	if (pFid == 0)
 		Id = 0;
 	else
 	{
-		unsigned int rawId = Feature_c::GetRawId(f);
+		unsigned int rawId = Feature_c::GetRawId(f, ent.HasCheckDigit);
 
 		if (rawId > 0)
 			Id = new FeatureId_c(rawId);
@@ -209,10 +210,35 @@ unsigned int Feature_c::GetRawId(const CeFeature& f)
 	CeEntity* ent = f.GetpEntity();
 	CeIdGroup* group = idMan->GetpGroup(ent);
 
-	unsigned int val;
-	sscanf(fid->FormatKey(), "%d", &val);
+	return GetRawId(f, group->HasCheckDigit());
+}
+
+// As above, for when it is already known whether the feature's ID group uses a check
+// digit (see IdFactory::GetEntityInfo)
+// static
+unsigned int Feature_c::GetRawId(const CeFeature& f, bool hasCheckDigit)
+{
+	if (f.IsForeignId())
+		return 0;
+
+	const CeFeatureId* const fid = f.GetpId();
+	if (fid == 0)
+		return 0;
 
-	if (group->HasCheckDigit())
+	if (!fid->GetKey().IsNumeric())
+		return 0;
+
+	// The key is known to be numeric, so just pick up the digits (this gets done for every
+	// feature, and sscanf is comparatively slow)
+	LPCTSTR key = fid->FormatKey();
+	while (*key == ' ')
+		key++;
+
+	unsigned int val = 0;
+	for (; *key >= '0' && *key <= '9'; key++)
+		val = val*10 + (unsigned int)(*key - '0');
+
+	if (hasCheckDigit)
 		return val/10;
 	else
 		return val;
@@ -323,8 +349,6 @@ void PointGeometry_c::Init(double x, double y)
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-#include "CedExporter.h"
-
 PointFeature_c::PointFeature_c(IdFactory& idf, const CePoint& p)
 	: Feature_c(idf, p)
 {
@@ -348,7 +372,7 @@ PointFeature_c::PointFeature_c(IdFactory& idf, unsigned int entityId, const CeLo
 void PointFeature_c::IndexAllLocations(IdFactory& idf, const CeLocation* loc, unsigned int id)
 {
 	CPtrArray locs;
-	CedExporter::GetAllCoincidentLocations(loc, locs);
+	idf.GetCoincidentLocations(loc, locs);
 
 	for (int i=0; i<locs.GetSize(); i++)
 	{
@@ -379,134 +403,20 @@ void PointFeature_c::WriteData(EditSerializer& s) const
 
 MultiSegmentGeometry_c::MultiSegmentGeometry_c(const CeMultiSegment& ms)
 {
-	for (int i=0; i<(int)ms.GetNumVertex(); i++)
-	{
-		const CeLocation* const loc = ms[i];
-		CString xy;
-		if (i == 0)
-			xy.Format("%lf %lf", loc->GetEasting(), loc->GetNorthing());
-		else
-			xy.Format(",%lf %lf", loc->GetEasting(), loc->GetNorthing());
+	NumVertex = ms.GetNumVertex();
+	XY = (double*)ExportArena::AllocateObject(2 * NumVertex * sizeof(double));
 
-		LineString += xy;
-	}
-
-	/*
-	unsigned int np = ms.GetNumVertex();
-	__int64* x = new __int64[np];
-	__int64* y = new __int64[np];
-
-	unsigned int i;
-	for (i=0; i<np; i++)
+	for (unsigned int i=0; i<NumVertex; i++)
 	{
 		const CeLocation* const loc = ms[i];
-		x[i] = (__int64)(loc->GetEasting() * 1000000.0);
-		y[i] = (__int64)(loc->GetNorthing() * 1000000.0);
+		XY[2*i] = loc->GetEasting();
+		XY[2*i+1] = loc->GetNorthing();
 	}
-
-    // Get the number of common high-order bytes for X and Y
-	int nx = CountCommonHighOrderBytes(x, np);
-	int ny = CountCommonHighOrderBytes(y, np);
-
-	// Figure out required array size (in bytes)
-    int sizeHeader = 2 + nx + ny;
-    int sizeDataX = np * (8-nx); 
-    int sizeDataY = np * (8-ny);
-
-	Length = sizeHeader + sizeDataX + sizeDataY;
-	Data = new __int8[Length];
-
-    // Define the header
-    Data[0] = (byte)nx;
-    Data[1] = (byte)ny;
-
-	// Copy over common high-order bytes for X
-	int from;
-    int to=2;
-	__int8 data[8];
-	FillByteArray(x[0], data);
-    for (from=0; from<nx; from++, to++)
-		Data[to] = data[from];
-
-	// Copy over common high-order bytes for Y
-	FillByteArray(y[0], data);
-	for (from=0; from<ny; from++, to++)
-		Data[to] = data[from];
-
-	// Copy over the low-order bytes for each (X,Y)
-
-    //to is currently = sizeHeader;
-    for (i=0; i<np; i++)
-    {
-		int j;
-        FillByteArray(x[i], data);
-        for (j=nx; j<8; j++)
-        {
-            Data[to] = data[j];
-            to++;
-        }
-
-        FillByteArray(y[i], data);
-        for (j=ny; j<8; j++)
-        {
-            Data[to] = data[j];
-            to++;
-        }
-    }
-
-	delete[] x;
-	delete[] y;
-	*/
 }
 
 MultiSegmentGeometry_c::~MultiSegmentGeometry_c()
 {
-	//delete[] Data;
-}
-
-// Counts the number of common high order bytes in an int64 array
-int MultiSegmentGeometry_c::CountCommonHighOrderBytes(__int64* data, int nData)
-{
-	int nCommon = 8;
-	__int8 common[8];
-	__int8 current[8];
-
-	FillByteArray(data[0], common);
-	
-    for (int i=1; i<nData && nCommon>0; i++)
-    {
-		FillByteArray(data[i], current);
-
-		for (int j=0; j<nCommon; j++)
-        {
-            if (common[j] != current[j])
-            {
-                nCommon = j;
-                break;
-            }
-        }
-    }
-
-	return nCommon;
-}
-
-// Copies bytes from an __int64 to a byte array (starting with the high order bytes)
-void MultiSegmentGeometry_c::FillByteArray(__int64 value, __int8* bytes)
-{
-	__int8* vs = (__int8*)&value;
-
-	for (int i=0; i<8; i++)
-		bytes[7-i] = vs[i];
-}
-
-// Fills an array with the high-order bytes from an __int64 (array element 0 is the highest order byte)
-void MultiSegmentGeometry_c::GetHighBytes(__int64 value, __int8* bytes, int nByte)
-{
-	__int8 all[8];
-	FillByteArray(value, all);
-
-	for (int i=0; i<nByte; i++)
-		bytes[i] = all[i];
+	ExportArena::FreeObject(XY);
 }
 
 LPCTSTR MultiSegmentGeometry_c::GetTypeName() const
@@ -517,8 +427,7 @@ LPCTSTR MultiSegmentGeometry_c::GetTypeName() const
 
 void MultiSegmentGeometry_c::WriteData(EditSerializer& s) const
 {
-	//s.WriteByteArray(DataField_Data, Data, Length);
-	s.WriteString(DataField_LineString, (LPCTSTR)LineString);
+	s.WriteLineString(DataField_LineString, DataField_Data, XY, NumVertex);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -52,7 +52,7 @@ class FeatureId_c : public Persistent_c
 public:
 	// One or the other (if NativeId==0, it's a foreign ID)
 	unsigned int NativeId;
-	CString* ForeignId;
+	LPTSTR ForeignId;
 
 	FeatureId_c(unsigned int nativeRawId);
 	FeatureId_c(LPCTSTR foreignId);
@@ -92,6 +92,7 @@ public:
 
 	static Feature_c* CreateExportFeature(IdFactory& idf, const CeFeature& f);
 	static unsigned int GetRawId(const CeFeature& f);
+	static unsigned int GetRawId(const CeFeature& f, bool hasCheckDigit);
 	static CeArc* GetFirstArc(CeObjectList& features);
 	static CePoint* GetFirstPoint(CeObjectList& features);
 
@@ -109,6 +110,9 @@ public:
 	__int64 X;
 	__int64 Y;
 
+	static void* operator new(size_t size) { return ExportArena::AllocateObject(size); }
+	static void operator delete(void* p) { ExportArena::FreeObject(p); }
+
 	PointGeometry_c(void);
 	PointGeometry_c(const CeLocation& loc);
 	PointGeometry_c(const CeVertex& p);
@@ -148,20 +152,14 @@ public:
 class MultiSegmentGeometry_c : public LineGeometry_c
 {
 public:
-	//unsigned int Length;
-	//__int8* Data;
-	CString LineString;
+	unsigned int NumVertex;
+	double* XY;		// The positions of the vertices (X and Y alternate)
 
 	MultiSegmentGeometry_c(const CeMultiSegment& mseg);
 
 	virtual ~MultiSegmentGeometry_c();
 	virtual LPCTSTR GetTypeName() const;
 	virtual void WriteData(EditSerializer& s) const;
-
-private:
-	int CountCommonHighOrderBytes(__int64* data, int nData);
-	void FillByteArray(__int64 value, __int8* bytes);
-	void GetHighBytes(__int64 value, __int8* bytes, int nByte);
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "DataField.h"
+
+/// <summary>
+/// Methods that may be used to persist the description of edits. This mirrors the
+/// IEditWriter interface in Backsight.Editor, except that items are tagged with a
+/// <see cref="DataField"/> value rather than a name.
+/// <para/>
+/// Implemented by <see cref="TextEditWriter"/> and <see cref="BinaryEditWriter"/>
+/// </summary>
+/// <remarks>
+/// Only basic data types should be mentioned as part of this interface. If you want to write any
+/// Backsight-specific types, you should provide an adapter method as part of the
+/// <see cref="EditSerializer"/> class.
+/// </remarks>
+class IEditWriter
+{
+public:
+	virtual ~IEditWriter(void) {}
+
+	/// <summary>
+	/// Writes an unsigned byte to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="value">The unsigned byte to write.</param>
+	virtual void WriteByte(DataField field, byte value) = 0;
+
+	/// <summary>
+	/// Writes a four-byte signed integer to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="value">The four-byte signed integer to write.</param>
+	virtual void WriteInt32(DataField field, int value) = 0;
+
+	/// <summary>
+	/// Writes a four-byte unsigned integer to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="value">The four-byte unsigned integer to write.</param>
+	virtual void WriteUInt32(DataField field, unsigned int value) = 0;
+
+	/// <summary>
+	/// Writes an eight-byte signed integer to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="value">The eight-byte signed integer to write.</param>
+	virtual void WriteInt64(DataField field, __int64 value) = 0;
+
+	/// <summary>
+	/// Writes an eight-byte floating-point value to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="value">The eight-byte floating-point value to write.</param>
+	virtual void WriteDouble(DataField field, double value) = 0;
+
+	/// <summary>
+	/// Writes an four-byte floating-point value to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="value">The four-byte floating-point value to write.</param>
+	virtual void WriteSingle(DataField field, float value) = 0;
+
+	/// <summary>
+	/// Writes a one-byte boolean value to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="value">The boolean value to write (0 or 1).</param>
+	virtual void WriteBool(DataField field, bool value) = 0;
+
+	/// <summary>
+	/// Writes a string to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="value">The string to write (if a null is supplied, just the tag will be written).</param>
+	virtual void WriteString(DataField field, LPCTSTR value) = 0;
+
+	/// <summary>
+	/// Writes a timestamp to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="when">The timestamp to write</param>
+	virtual void WriteDateTime(DataField field, const CTime& value) = 0;
+
+	/// <summary>
+	/// Writes an internal ID to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="id">The internal ID to write</param>
+	virtual void WriteInternalId(DataField field, unsigned int id) = 0;
+
+	/// <summary>
+	/// Writes an array of bytes to a storage medium.
+	/// </summary>
+	/// <param name="field">The tag that identifies the item.</param>
+	/// <param name="data">The bytes to write</param>
+	/// <param name="length">The number of bytes to write</param>
+	virtual void WriteBytes(DataField field, const byte* data, unsigned int length) = 0;
+
+	/// <summary>
+	/// Writes the type name for an element in an array of objects. This takes the place
+	/// of the tag that would precede a standalone object, and will be followed by a call
+	/// to <see cref="WriteBeginObject"/>.
+	/// </summary>
+	/// <param name="index">The array index of the element (0 for the first element)</param>
+	/// <param name="typeName">The exported type name of the element.</param>
+	virtual void WriteArrayItem(unsigned int index, LPCTSTR typeName) = 0;
+
+	/// <summary>
+	/// Writes anything that precedes the data values for an object.
+	/// </summary>
+	virtual void WriteBeginObject() = 0;
+
+	/// <summary>
+	/// Writes anything that follows the data values for an object.
+	/// </summary>
+	virtual void WriteEndObject() = 0;
+};
@@ -0,0 +1,99 @@
+#include "StdAfx.h"
+#include "BinaryEditWriter.h"
+#include "LineStringCodec.h"
+
+// Encodes an array of vertices (X and Y values alternate, so the array holds 2*numVertex
+// values). The buffer must have room for GetMaxLength(numVertex) bytes. Returns the number
+// of bytes actually used.
+unsigned int LineStringCodec::Encode(byte* buf, const __int64* xy, unsigned int numVertex)
+{
+	byte* p = buf;
+	p += BinaryEditWriter::FormatVarint(p, numVertex);
+
+	__int64 lastX = 0;
+	__int64 lastY = 0;
+
+	for (unsigned int i=0; i<numVertex; i++)
+	{
+		__int64 x = xy[2*i];
+		__int64 y = xy[2*i+1];
+
+		// The subtraction is done unsigned, so that it wraps (rather than overflows) for
+		// values that are very far apart. Decode wraps the same way.
+		p += BinaryEditWriter::FormatVarint(p, ZigZag((__int64)((unsigned __int64)x - (unsigned __int64)lastX)));
+		p += BinaryEditWriter::FormatVarint(p, ZigZag((__int64)((unsigned __int64)y - (unsigned __int64)lastY)));
+
+		lastX = x;
+		lastY = y;
+	}
+
+	return (unsigned int)(p - buf);
+}
+
+// Decodes data produced by Encode. Returns an array of 2*numVertex values (to be released
+// with delete[] by the caller), or null if the data is not properly formed.
+__int64* LineStringCodec::Decode(const byte* data, unsigned int length, unsigned int& numVertex)
+{
+	const byte* p = data;
+	const byte* end = data + length;
+	numVertex = 0;
+
+	// Each vertex needs at least 2 bytes, which guards against a bogus count
+	unsigned __int64 count;
+	if (!ReadVarint(p, end, count) || count > (unsigned __int64)(end - p) / 2)
+		return 0;
+
+	__int64* xy = new __int64[2 * (unsigned int)count];
+	unsigned __int64 x = 0;
+	unsigned __int64 y = 0;
+
+	for (unsigned int i=0; i<(unsigned int)count; i++)
+	{
+		unsigned __int64 dx, dy;
+		if (!ReadVarint(p, end, dx) || !ReadVarint(p, end, dy))
+		{
+			delete [] xy;
+			return 0;
+		}
+
+		x += (unsigned __int64)UnZigZag(dx);
+		y += (unsigned __int64)UnZigZag(dy);
+		xy[2*i] = (__int64)x;
+		xy[2*i+1] = (__int64)y;
+	}
+
+	// Anything left over means the data isn't what we thought it was
+	if (p != end)
+	{
+		delete [] xy;
+		return 0;
+	}
+
+	numVertex = (unsigned int)count;
+	return xy;
+}
+
+// Reads a varint, advancing the supplied pointer. Returns false if the data runs out, or
+// if the value is too big to fit in 64 bits.
+bool LineStringCodec::ReadVarint(const byte*& p, const byte* end, unsigned __int64& value)
+{
+	value = 0;
+
+	for (unsigned int shift=0; shift<64; shift+=7)
+	{
+		if (p == end)
+			return false;
+
+		// The tenth byte only has room for the top bit
+		byte b = *p++;
+		if (shift == 63 && b > 1)
+			return false;
+
+		value |= ((unsigned __int64)(b & 0x7F) << shift);
+
+		if ((b & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// Packs the vertices of a line into a compact byte array (and back again). Coordinates are
+// expressed in microns, as for PointGeometry_c. The array starts with the number of vertices,
+// followed by the change in X and Y from one vertex to the next (the first vertex is taken
+// relative to 0,0). Each value is zigzag encoded (so that small negative values stay small),
+// then written as a varint of the sort produced by BinaryEditWriter::FormatVarint.
+//
+// Since adjacent vertices are usually close together, a vertex typically takes 4 to 6 bytes,
+// rather than the 30 or so characters needed to express it in text.
+class LineStringCodec
+{
+public:
+	// The most bytes that Encode could need for the specified number of vertices
+	static unsigned int GetMaxLength(unsigned int numVertex)
+	{
+		return 10 + numVertex * 20;
+	}
+
+	static unsigned int Encode(byte* buf, const __int64* xy, unsigned int numVertex);
+	static __int64* Decode(const byte* data, unsigned int length, unsigned int& numVertex);
+
+	static unsigned __int64 ZigZag(__int64 value)
+	{
+		return ((unsigned __int64)value << 1) ^ (unsigned __int64)(value >> 63);
+	}
+
+	static __int64 UnZigZag(unsigned __int64 value)
+	{
+		return (__int64)(value >> 1) ^ -(__int64)(value & 1);
+	}
+
+private:
+	static bool ReadVarint(const byte*& p, const byte* end, unsigned __int64& value);
+};
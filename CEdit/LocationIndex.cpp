@@ -0,0 +1,112 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include <math.h>
+
+#ifdef _CEDIT
+#include "CeTile.h"
+#include "CeTileId.h"
+#include "CeTileData.h"
+#include "CeLocation.h"
+#endif
+
+#include "LocationIndex.h"
+
+// One millimeter (CEdit holds positions to the nearest micron)
+const double LocationIndex::CellSize = (double)LocationIndex::CellMicrons / 1000000.0;
+
+LocationIndex::LocationIndex()
+{
+	m_NumNode = 0;
+	m_MaxNode = 4096;
+	m_Nodes = (Node*)malloc(m_MaxNode * sizeof(Node));
+
+	m_Bits = 12;
+	m_Buckets = (unsigned int*)calloc((size_t)1 << m_Bits, sizeof(unsigned int));
+}
+
+LocationIndex::~LocationIndex()
+{
+	free(m_Nodes);
+	free(m_Buckets);
+}
+
+// Obtains all locations that coincide with the supplied location (including the
+// supplied location itself). Only the tile that contains the location is considered.
+void LocationIndex::GetCoincidentLocations(const CeLocation* loc, CPtrArray& locs)
+{
+	if (loc == 0)
+		return;
+
+	const CeTile* t = loc->GetTileID().GetpTile();
+	unsigned int junk;
+	if (!m_Tiles.Lookup(t, junk))
+	{
+		IndexTile(t);
+		m_Tiles.SetAt(t, 1);
+	}
+
+	__int64 cx = GetCell(loc->GetEasting());
+	__int64 cy = GetCell(loc->GetNorthing());
+
+	for (__int64 x = cx-1; x <= cx+1; x++)
+	{
+		for (__int64 y = cy-1; y <= cy+1; y++)
+		{
+			for (unsigned int i = m_Buckets[GetBucket(t, x, y)]; i != 0; i = m_Nodes[i-1].Next)
+			{
+				const Node& n = m_Nodes[i-1];
+				if (n.Tile == t && n.CellX == x && n.CellY == y && (*loc) == (*n.Loc))
+					locs.Add((void*)n.Loc);
+			}
+		}
+	}
+}
+
+// Adds every location in a tile to the index
+void LocationIndex::IndexTile(const CeTile* t)
+{
+	for (const CeTileData* td = t->GetpTileData()->GetpTail(); td; td = td->GetpPrev())
+	{
+		unsigned int nLoc = td->GetNumLoc();
+		const CeLocation** tLocs = td->GetpLocations();
+
+		for (unsigned int i=0; i<nLoc; i++)
+			AddNode(tLocs[i], t);
+	}
+}
+
+void LocationIndex::AddNode(const CeLocation* loc, const CeTile* t)
+{
+	if (m_NumNode == m_MaxNode)
+		Grow();
+
+	Node& n = m_Nodes[m_NumNode];
+	n.Loc = loc;
+	n.Tile = t;
+	n.CellX = GetCell(loc->GetEasting());
+	n.CellY = GetCell(loc->GetNorthing());
+
+	unsigned int b = GetBucket(t, n.CellX, n.CellY);
+	n.Next = m_Buckets[b];
+	m_NumNode++;
+	m_Buckets[b] = m_NumNode;
+}
+
+// Doubles the space for nodes, and the number of buckets (re-linking the existing nodes)
+void LocationIndex::Grow()
+{
+	m_MaxNode *= 2;
+	m_Nodes = (Node*)realloc(m_Nodes, m_MaxNode * sizeof(Node));
+
+	free(m_Buckets);
+	m_Bits++;
+	m_Buckets = (unsigned int*)calloc((size_t)1 << m_Bits, sizeof(unsigned int));
+
+	for (unsigned int i=0; i<m_NumNode; i++)
+	{
+		Node& n = m_Nodes[i];
+		unsigned int b = GetBucket(n.Tile, n.CellX, n.CellY);
+		n.Next = m_Buckets[b];
+		m_Buckets[b] = i+1;
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <math.h>
+#include "PtrIdTable.h"
+
+#ifdef _CEDIT
+class CeLocation;
+class CeTile;
+#else
+#include "CEditStubs.h"
+#endif
+
+// An index of the locations in a CED file, used to find coincident locations quickly. Each
+// tile is indexed the first time one of its locations is looked up. Locations are grouped by
+// tile and by a small grid cell (CellSize on a side). A lookup checks the cell containing the
+// location plus its 8 neighbours, and confirms candidates using CeLocation::operator==. This
+// gives the same result as scanning every location in the tile, provided that operator==
+// never treats positions more than CellSize apart as equal (Tests\LocationIndexTest.cpp
+// checks the index against a linear scan, for matches over distances up to CellSize).
+class LocationIndex
+{
+public:
+	// The size of the grid cells, in meters on the ground
+	static const double CellSize;
+
+	LocationIndex();
+	~LocationIndex();
+
+	void GetCoincidentLocations(const CeLocation* loc, CPtrArray& locs);
+	unsigned int GetNumTile() const { return m_Tiles.GetCount(); }
+	unsigned int GetNumLoc() const { return m_NumNode; }
+
+private:
+	struct Node
+	{
+		const CeLocation* Loc;
+		const CeTile* Tile;
+		__int64 CellX;
+		__int64 CellY;
+		unsigned int Next;		// One more than the array index of the next node in the same bucket (0 if none)
+	};
+
+	void IndexTile(const CeTile* t);
+	void AddNode(const CeLocation* loc, const CeTile* t);
+	void Grow();
+
+	unsigned int GetBucket(const CeTile* t, __int64 cx, __int64 cy) const
+	{
+		unsigned __int64 h = (unsigned __int64)(size_t)t;
+		h = (h ^ (unsigned __int64)cx) * 0x9E3779B97F4A7C15ull;
+		h = (h ^ (unsigned __int64)cy) * 0x9E3779B97F4A7C15ull;
+		return (unsigned int)(h >> (64 - m_Bits));
+	}
+
+	// Cells are worked out from the position in whole microns (the precision CEdit holds), so
+	// positions that are CellSize apart are never more than one cell apart (dividing the value
+	// in meters by CellSize can round either way when a position is on the edge of a cell).
+	static __int64 GetCell(double v)
+	{
+		__int64 microns = (__int64)floor(v * 1000000.0 + 0.5);
+		if (microns >= 0)
+			return microns / CellMicrons;
+		else
+			return -((CellMicrons - 1 - microns) / CellMicrons);
+	}
+
+	// The size of the grid cells, in microns
+	static const __int64 CellMicrons = 1000;
+
+	// The tiles that have been indexed (the value is unused)
+	PtrIdTable m_Tiles;
+
+	Node* m_Nodes;
+	unsigned int m_NumNode;
+	unsigned int m_MaxNode;
+
+	// For each bucket, one more than the index of the first node (0 if the bucket is empty)
+	unsigned int* m_Buckets;
+	unsigned int m_Bits;
+};
@@ -0,0 +1,100 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include "MappedOutputBuffer.h"
+
+MappedOutputBuffer::MappedOutputBuffer(LPCTSTR fileName, unsigned int viewSize)
+{
+	m_Mapping = 0;
+	m_View = 0;
+	m_ViewSize = viewSize;
+	m_NumViews = 0;
+
+	m_FileHandle = CreateFile(fileName, GENERIC_READ | GENERIC_WRITE, 0, 0,
+								CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+
+	if (m_FileHandle != INVALID_HANDLE_VALUE)
+		MapView(0);
+}
+
+MappedOutputBuffer::~MappedOutputBuffer()
+{
+	Close();
+}
+
+// The data is already in the file's pages, so there is nothing to write. Leave it to the
+// system to decide when the pages go to disk.
+void MappedOutputBuffer::Flush()
+{
+}
+
+// Unmaps the file, and cuts it back to the length of what was written
+void MappedOutputBuffer::Close()
+{
+	if (m_FileHandle == INVALID_HANDLE_VALUE)
+		return;
+
+	unsigned __int64 total = GetTotalBytes();
+	UnmapView();
+
+	LARGE_INTEGER size;
+	size.QuadPart = (LONGLONG)total;
+	SetFilePointerEx(m_FileHandle, size, 0, FILE_BEGIN);
+	SetEndOfFile(m_FileHandle);
+
+	CloseHandle(m_FileHandle);
+	m_FileHandle = INVALID_HANDLE_VALUE;
+	m_Length = 0;
+	m_Size = 0;
+}
+
+// Moves the view on to the end of what has been written so far
+void MappedOutputBuffer::MakeRoom(unsigned int n)
+{
+	m_Flushed += m_Length;
+	m_Length = 0;
+	UnmapView();
+	MapView(n);
+}
+
+// Maps the part of the file that starts at the current end of the output. Views have to
+// start on an allocation boundary, so the view may start a bit before the end of the output.
+void MappedOutputBuffer::MapView(unsigned int minSize)
+{
+	assert(m_View == 0);
+
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	unsigned __int64 start = m_Flushed - (m_Flushed % si.dwAllocationGranularity);
+	unsigned int skip = (unsigned int)(m_Flushed - start);
+	unsigned int viewSize = max(m_ViewSize, skip + minSize);
+
+	// Creating a mapping that is bigger than the file extends the file
+	unsigned __int64 end = start + viewSize;
+	m_Mapping = CreateFileMapping(m_FileHandle, 0, PAGE_READWRITE, (DWORD)(end >> 32), (DWORD)end, 0);
+	if (m_Mapping != 0)
+		m_View = (char*)MapViewOfFile(m_Mapping, FILE_MAP_WRITE, (DWORD)(start >> 32), (DWORD)start, viewSize);
+
+	if (m_View == 0)
+		AfxThrowMemoryException();
+
+	m_NumViews++;
+	m_Data = m_View + skip;
+	m_Size = viewSize - skip;
+}
+
+void MappedOutputBuffer::UnmapView()
+{
+	if (m_View != 0)
+	{
+		UnmapViewOfFile(m_View);
+		m_View = 0;
+	}
+
+	if (m_Mapping != 0)
+	{
+		CloseHandle(m_Mapping);
+		m_Mapping = 0;
+	}
+
+	m_Data = 0;
+}
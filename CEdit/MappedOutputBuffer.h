@@ -0,0 +1,39 @@
+#pragma once
+#include "OutputBuffer.h"
+
+// An output buffer that is a view of a memory-mapped file. Output gets formatted straight
+// into the file's pages, so there is no copying through stdio, and the system writes the
+// pages back in its own time. When the view fills up, it is unmapped and the next part of
+// the file is mapped in its place (extending the file as necessary). When the buffer is
+// closed (or destroyed), the file is truncated to the length of what was actually written.
+//
+// The file is always written as raw bytes, so text written this way has plain "\n" line
+// endings, rather than the "\r\n" that a text-mode stdio file would produce.
+class MappedOutputBuffer : public OutputBuffer
+{
+public:
+	// The amount of the file mapped at any one time
+	static const unsigned int DefaultViewSize = 64*1024*1024;
+
+	MappedOutputBuffer(LPCTSTR fileName, unsigned int viewSize = DefaultViewSize);
+	virtual ~MappedOutputBuffer();
+
+	bool IsOpen() const { return m_FileHandle != INVALID_HANDLE_VALUE; }
+	virtual void Flush();
+	void Close();
+
+	unsigned int GetNumViews() const { return m_NumViews; }
+
+protected:
+	virtual void MakeRoom(unsigned int n);
+
+private:
+	void MapView(unsigned int minSize);
+	void UnmapView();
+
+	HANDLE m_FileHandle;
+	HANDLE m_Mapping;
+	char* m_View;				// The start of the current view (m_Data may be a little way in)
+	unsigned int m_ViewSize;	// The requested size for each view
+	unsigned int m_NumViews;	// The number of views mapped so far
+};
@@ -0,0 +1,299 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include <ctype.h>
+#include "NameIdTable.h"
+
+// The first bytes of a cache file
+static const char CacheFileMagic[4] = { 'C', 'N', 'I', 'T' };
+
+// The version of the cache file layout
+static const unsigned int CacheFileVersion = 1;
+
+// The fixed-size part at the start of a cache file
+struct CacheFileHeader
+{
+	char Magic[4];
+	unsigned int Version;
+	__int64 SourceTime;
+	unsigned __int64 SourceSize;
+	unsigned int Count;
+	unsigned int NamesLength;
+};
+
+// An entry while the table is being sorted
+struct SortEntry
+{
+	const char* Name;
+	int Id;
+	unsigned int Order;		// Where the entry came in the text file
+};
+
+static int CompareSortEntries(const void* a, const void* b)
+{
+	const SortEntry* sa = (const SortEntry*)a;
+	const SortEntry* sb = (const SortEntry*)b;
+
+	int cmp = strcmp(sa->Name, sb->Name);
+	if (cmp != 0)
+		return cmp;
+
+	return (sa->Order < sb->Order ? -1 : (sa->Order > sb->Order ? 1 : 0));
+}
+
+NameIdTable::NameIdTable()
+{
+	m_Names = 0;
+	m_NamesLength = m_MaxNamesLength = 0;
+	m_Entries = 0;
+	m_Count = m_MaxCount = 0;
+	m_IsFromCache = false;
+}
+
+NameIdTable::~NameIdTable()
+{
+	Clear();
+}
+
+void NameIdTable::Clear()
+{
+	free(m_Names);
+	m_Names = 0;
+	m_NamesLength = m_MaxNamesLength = 0;
+
+	free(m_Entries);
+	m_Entries = 0;
+	m_Count = m_MaxCount = 0;
+
+	m_IsFromCache = false;
+}
+
+// Loads the table for a translation file, using the cached form if the file hasn't changed
+// since the cache was written. Returns false if the file could not be read (in that case, the
+// table will be empty).
+bool NameIdTable::Load(LPCTSTR fileName)
+{
+	Clear();
+
+	CFileStatus fileStatus;
+	if (!CFile::GetStatus(fileName, fileStatus))
+		return false;
+
+	__int64 sourceTime = (__int64)fileStatus.m_mtime.GetTime();
+	unsigned __int64 sourceSize = (unsigned __int64)fileStatus.m_size;
+
+	CString cacheFileName(fileName);
+	cacheFileName += ".cache";
+
+	if (ReadCache((LPCTSTR)cacheFileName, sourceTime, sourceSize))
+	{
+		m_IsFromCache = true;
+		return true;
+	}
+
+	if (!ReadText(fileName))
+		return false;
+
+	WriteCache((LPCTSTR)cacheFileName, sourceTime, sourceSize);
+	return true;
+}
+
+// Returns the index of the entry for a name (-1 if the name isn't in the table)
+int NameIdTable::Find(LPCTSTR name) const
+{
+	if (name == 0)
+		return -1;
+
+	unsigned int lo = 0;
+	unsigned int hi = m_Count;
+
+	while (lo < hi)
+	{
+		unsigned int mid = lo + (hi - lo) / 2;
+		int cmp = strcmp(m_Names + m_Entries[mid].NameOffset, name);
+
+		if (cmp == 0)
+			return (int)mid;
+
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return -1;
+}
+
+// Returns the ID for a name (0 if the name isn't in the table)
+int NameIdTable::Lookup(LPCTSTR name) const
+{
+	int index = Find(name);
+	return (index < 0 ? 0 : m_Entries[index].Id);
+}
+
+// Parses a translation file. Each line holds an ID, followed by "=", followed by a name
+// (leading and trailing whitespace is ignored). If a name appears more than once, the last
+// line for it applies.
+bool NameIdTable::ReadText(LPCTSTR fileName)
+{
+	FILE* fp = fopen(fileName, "r");
+	if (fp == 0)
+		return false;
+
+	char buf[1024];
+
+	while (fgets(buf, sizeof(buf), fp))
+	{
+		char* eq = strchr(buf, '=');
+		if (eq == 0)
+			continue;
+
+		// The ID (a line that starts with "=" has no ID, so gets skipped)
+		char* s = buf;
+		while (isspace((unsigned char)*s))
+			s++;
+
+		if (s == eq)
+			continue;
+
+		int id = atoi(s);
+
+		// The name
+		char* name = eq + 1;
+		while (isspace((unsigned char)*name))
+			name++;
+
+		char* end = name + strlen(name);
+		while (end > name && isspace((unsigned char)end[-1]))
+			end--;
+
+		AddEntry(name, (unsigned int)(end - name), id);
+	}
+
+	fclose(fp);
+	Sort();
+	return true;
+}
+
+void NameIdTable::AddEntry(const char* name, unsigned int nameLength, int id)
+{
+	if (m_Count == m_MaxCount)
+	{
+		m_MaxCount = (m_MaxCount == 0 ? 256 : m_MaxCount*2);
+		m_Entries = (Entry*)realloc(m_Entries, m_MaxCount * sizeof(Entry));
+	}
+
+	if (m_NamesLength + nameLength + 1 > m_MaxNamesLength)
+	{
+		m_MaxNamesLength = max(m_NamesLength + nameLength + 1, 2 * m_MaxNamesLength);
+		m_Names = (char*)realloc(m_Names, m_MaxNamesLength);
+	}
+
+	Entry& e = m_Entries[m_Count++];
+	e.NameOffset = m_NamesLength;
+	e.Id = id;
+
+	memcpy(m_Names + m_NamesLength, name, nameLength);
+	m_NamesLength += nameLength;
+	m_Names[m_NamesLength++] = '\0';
+}
+
+// Sorts the entries by name, discarding all but the last entry for any name that was
+// added more than once
+void NameIdTable::Sort()
+{
+	if (m_Count == 0)
+		return;
+
+	SortEntry* sorted = (SortEntry*)malloc(m_Count * sizeof(SortEntry));
+	for (unsigned int i=0; i<m_Count; i++)
+	{
+		sorted[i].Name = m_Names + m_Entries[i].NameOffset;
+		sorted[i].Id = m_Entries[i].Id;
+		sorted[i].Order = i;
+	}
+
+	qsort(sorted, m_Count, sizeof(SortEntry), CompareSortEntries);
+
+	unsigned int n = 0;
+	for (unsigned int i=0; i<m_Count; i++)
+	{
+		if (i+1 < m_Count && strcmp(sorted[i].Name, sorted[i+1].Name) == 0)
+			continue;
+
+		m_Entries[n].NameOffset = (unsigned int)(sorted[i].Name - m_Names);
+		m_Entries[n].Id = sorted[i].Id;
+		n++;
+	}
+
+	m_Count = n;
+	free(sorted);
+}
+
+// Reads the cached form of the table, returning false if the cache is missing, or if it
+// was produced from a different version of the text file
+bool NameIdTable::ReadCache(LPCTSTR cacheFileName, __int64 sourceTime, unsigned __int64 sourceSize)
+{
+	FILE* fp = fopen(cacheFileName, "rb");
+	if (fp == 0)
+		return false;
+
+	CacheFileHeader h;
+	bool ok = (fread(&h, sizeof(h), 1, fp) == 1 &&
+				memcmp(h.Magic, CacheFileMagic, sizeof(h.Magic)) == 0 &&
+				h.Version == CacheFileVersion &&
+				h.SourceTime == sourceTime &&
+				h.SourceSize == sourceSize);
+
+	if (ok)
+	{
+		m_Entries = (Entry*)malloc(h.Count * sizeof(Entry));
+		m_Names = (char*)malloc(h.NamesLength);
+		m_MaxCount = m_Count = h.Count;
+		m_MaxNamesLength = m_NamesLength = h.NamesLength;
+
+		ok = (fread(m_Entries, sizeof(Entry), m_Count, fp) == m_Count &&
+				fread(m_Names, 1, m_NamesLength, fp) == m_NamesLength);
+
+		// Don't trust name offsets that lead outside the names
+		for (unsigned int i=0; ok && i<m_Count; i++)
+			ok = (m_Entries[i].NameOffset < m_NamesLength);
+
+		if (ok && m_NamesLength > 0)
+			ok = (m_Names[m_NamesLength-1] == '\0');
+	}
+
+	fclose(fp);
+
+	if (!ok)
+		Clear();
+
+	return ok;
+}
+
+// Writes the cached form of the table (if the cache can't be written, the text file will
+// just be parsed again next time)
+void NameIdTable::WriteCache(LPCTSTR cacheFileName, __int64 sourceTime, unsigned __int64 sourceSize) const
+{
+	FILE* fp = fopen(cacheFileName, "wb");
+	if (fp == 0)
+		return;
+
+	CacheFileHeader h;
+	memcpy(h.Magic, CacheFileMagic, sizeof(h.Magic));
+	h.Version = CacheFileVersion;
+	h.SourceTime = sourceTime;
+	h.SourceSize = sourceSize;
+	h.Count = m_Count;
+	h.NamesLength = m_NamesLength;
+
+	bool ok = (fwrite(&h, sizeof(h), 1, fp) == 1 &&
+				fwrite(m_Entries, sizeof(Entry), m_Count, fp) == m_Count &&
+				fwrite(m_Names, 1, m_NamesLength, fp) == m_NamesLength);
+
+	if (fclose(fp) != 0)
+		ok = false;
+
+	// Don't leave a partial cache behind
+	if (!ok)
+		remove(cacheFileName);
+}
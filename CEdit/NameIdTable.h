@@ -0,0 +1,53 @@
+#pragma once
+
+// A table that translates names into numeric IDs, as defined by one of the translation files
+// in C:\Backsight\CEdit (lines of the form "id=name"). The names are held in one block of
+// memory, and the entries are sorted by name, so a lookup is a binary search that doesn't
+// allocate anything.
+//
+// Parsing the text file is only done when it has changed. The sorted table is cached in a
+// binary file alongside (the same name, with ".cache" appended), which records the time and
+// size of the text file it was produced from. If they no longer match, the text file gets
+// parsed again, and the cache is rewritten.
+class NameIdTable
+{
+public:
+	NameIdTable();
+	~NameIdTable();
+
+	bool Load(LPCTSTR fileName);
+
+	int Find(LPCTSTR name) const;
+	int Lookup(LPCTSTR name) const;
+
+	unsigned int GetCount() const { return m_Count; }
+	LPCTSTR GetName(int index) const { return m_Names + m_Entries[index].NameOffset; }
+	int GetId(int index) const { return m_Entries[index].Id; }
+
+	// Was the table obtained from the cache (rather than by parsing the text file)?
+	bool IsFromCache() const { return m_IsFromCache; }
+
+private:
+	struct Entry
+	{
+		unsigned int NameOffset;	// Where the name starts in m_Names
+		int Id;
+	};
+
+	void Clear();
+	bool ReadText(LPCTSTR fileName);
+	bool ReadCache(LPCTSTR cacheFileName, __int64 sourceTime, unsigned __int64 sourceSize);
+	void WriteCache(LPCTSTR cacheFileName, __int64 sourceTime, unsigned __int64 sourceSize) const;
+	void AddEntry(const char* name, unsigned int nameLength, int id);
+	void Sort();
+
+	char* m_Names;
+	unsigned int m_NamesLength;
+	unsigned int m_MaxNamesLength;
+
+	Entry* m_Entries;
+	unsigned int m_Count;
+	unsigned int m_MaxCount;
+
+	bool m_IsFromCache;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include "IEditWriter.h"
+
+// An edit writer that discards everything it is given, just keeping a count of the
+// number of values and objects. This makes it possible to time the construction and
+// traversal of the export objects independently of any formatting or I/O.
+class NullEditWriter : public IEditWriter
+{
+public:
+	NullEditWriter() : m_NumValues(0), m_NumObjects(0) {}
+	virtual ~NullEditWriter(void) {}
+
+	void WriteBeginObject() { m_NumObjects++; }
+	void WriteEndObject() {}
+	void WriteArrayItem(unsigned int index, LPCTSTR typeName) { m_NumValues++; }
+	void WriteByte(DataField field, byte value) { m_NumValues++; }
+    void WriteInt32(DataField field, int value) { m_NumValues++; }
+    void WriteUInt32(DataField field, unsigned int value) { m_NumValues++; }
+    void WriteInt64(DataField field, __int64 value) { m_NumValues++; }
+    void WriteDouble(DataField field, double value) { m_NumValues++; }
+    void WriteSingle(DataField field, float value) { m_NumValues++; }
+    void WriteBool(DataField field, bool value) { m_NumValues++; }
+    void WriteString(DataField field, LPCTSTR value) { m_NumValues++; }
+    void WriteDateTime(DataField field, const CTime& value) { m_NumValues++; }
+    void WriteInternalId(DataField field, unsigned int id) { m_NumValues++; }
+    void WriteBytes(DataField field, const byte* data, unsigned int length) { m_NumValues++; }
+
+	unsigned int GetNumValues() const { return m_NumValues; }
+	unsigned int GetNumObjects() const { return m_NumObjects; }
+
+private:
+	unsigned int m_NumValues;
+	unsigned int m_NumObjects;
+};
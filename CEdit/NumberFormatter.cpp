@@ -0,0 +1,214 @@
+#include "StdAfx.h"
+#include <math.h>
+#include "NumberFormatter.h"
+
+unsigned int NumberFormatter::FormatUInt64(char* buf, unsigned __int64 value)
+{
+	// Generate the digits backwards, then copy them over
+	char tmp[24];
+	char* p = tmp + sizeof(tmp);
+
+	do
+	{
+		*--p = (char)('0' + (unsigned int)(value % 10));
+		value /= 10;
+	} while (value != 0);
+
+	unsigned int len = (unsigned int)(tmp + sizeof(tmp) - p);
+	memcpy(buf, p, len);
+	return len;
+}
+
+unsigned int NumberFormatter::FormatUInt32(char* buf, unsigned int value)
+{
+	char tmp[12];
+	char* p = tmp + sizeof(tmp);
+
+	do
+	{
+		*--p = (char)('0' + value % 10);
+		value /= 10;
+	} while (value != 0);
+
+	unsigned int len = (unsigned int)(tmp + sizeof(tmp) - p);
+	memcpy(buf, p, len);
+	return len;
+}
+
+unsigned int NumberFormatter::FormatInt32(char* buf, int value)
+{
+	if (value >= 0)
+		return FormatUInt32(buf, (unsigned int)value);
+
+	// Negate as unsigned so that INT_MIN comes out right
+	buf[0] = '-';
+	return 1 + FormatUInt32(buf+1, 0u - (unsigned int)value);
+}
+
+unsigned int NumberFormatter::FormatInt64(char* buf, __int64 value)
+{
+	if (value >= 0)
+		return FormatUInt64(buf, (unsigned __int64)value);
+
+	buf[0] = '-';
+	return 1 + FormatUInt64(buf+1, 0ull - (unsigned __int64)value);
+}
+
+// Formats a double with 6 decimal places. Values that are too big for the fast path (or
+// that lie so close to a rounding boundary that the outcome is in doubt) are passed to
+// sprintf, so the result is always the same as what "%f" would produce.
+unsigned int NumberFormatter::FormatFixed6(char* buf, double value)
+{
+	double a = fabs(value);
+
+	// The comparison is false for NaN
+	if (!(a < 1.0e9))
+		return (unsigned int)sprintf(buf, "%f", value);
+
+	// Splitting off the whole part is exact, so the only rounding error comes
+	// from scaling the fraction (which is well under 1e-9 of a unit in the 6th place)
+	double whole = floor(a);
+	double micro = (a - whole) * 1.0e6;
+	double rmicro = floor(micro);
+	double rem = micro - rmicro;
+
+	if (fabs(rem - 0.5) < 1.0e-9)
+		return (unsigned int)sprintf(buf, "%f", value);
+
+	unsigned int ipart = (unsigned int)whole;
+	unsigned int fpart = (unsigned int)rmicro;
+	if (rem > 0.5)
+		fpart++;
+
+	if (fpart >= 1000000)
+	{
+		fpart -= 1000000;
+		ipart++;
+	}
+
+	// sprintf keeps the sign of negative values that round to zero (including -0.0)
+	char* p = buf;
+	if (value < 0.0 || (value == 0.0 && 1.0/value < 0.0))
+		*p++ = '-';
+
+	p += FormatUInt32(p, ipart);
+	*p++ = '.';
+
+	for (int i=5; i>=0; i--)
+	{
+		p[i] = (char)('0' + fpart % 10);
+		fpart /= 10;
+	}
+
+	return (unsigned int)(p + 6 - buf);
+}
+
+// The most characters that FormatLineString could produce for the specified vertices (a
+// separator goes between each value)
+unsigned int NumberFormatter::GetMaxLineStringLength(const double* xy, unsigned int numVertex)
+{
+	unsigned int maxLength = 0;
+	for (unsigned int i=0; i<2*numVertex; i++)
+		maxLength += GetMaxFixed6Length(xy[i]) + 1;
+
+	return maxLength;
+}
+
+unsigned int NumberFormatter::FormatLineString(char* buf, const double* xy, unsigned int numVertex)
+{
+	char* p = buf;
+
+	for (unsigned int i=0; i<numVertex; i++)
+	{
+		if (i > 0)
+			*p++ = ',';
+
+		p += FormatFixed6(p, xy[2*i]);
+		*p++ = ' ';
+		p += FormatFixed6(p, xy[2*i+1]);
+	}
+
+	return (unsigned int)(p - buf);
+}
+
+// Formats an angle the way EditSerializer used to (via modf, sprintf and strcat). The
+// degrees and minutes are split off exactly as before, then the seconds are converted
+// once to integer milliseconds of arc. Rounding to the millisecond goes through sprintf
+// only when the seconds lie so close to a half-millisecond that the outcome is in doubt.
+unsigned int NumberFormatter::FormatRadians(char* buf, double value, bool isDeflection)
+{
+	// Convert to decimal degrees (possibly signed).
+	const double RADTODEG = 360.0 / (2.0 * 3.14159265358979323846);
+	double sdeg = value * RADTODEG;
+
+	// Get the degrees, minutes, and seconds, all unsigned.
+	double adeg = fabs(sdeg);
+	double deg = floor(adeg);
+	double mins = (adeg - deg) * 60.0;
+	double wmins = floor(mins);
+	double secs = (mins - wmins) * 60.0;
+
+	unsigned int ideg  = (unsigned int)(deg + 0.1);
+	unsigned int imins = (unsigned int)(wmins + 0.1);
+
+	// Seconds within a millisecond of 60 carry into the minutes, and seconds under
+	// a millisecond are dropped (these are the thresholds the old code used, which
+	// are not quite the same as rounding to 3 decimals).
+	unsigned int msecs = 0;
+
+	if (fabs(secs - 60.0) < 0.001)
+		imins++;
+	else if (secs >= 0.001)
+	{
+		double ms = secs * 1000.0;
+		double wms = floor(ms);
+		double rem = ms - wms;
+
+		if (fabs(rem - 0.5) < 1.0e-9)
+		{
+			char tmp[16];
+			sprintf(tmp, "%.3f", secs);
+			msecs = (unsigned int)(atof(tmp) * 1000.0 + 0.5);
+		}
+		else
+		{
+			msecs = (unsigned int)wms;
+			if (rem > 0.5)
+				msecs++;
+		}
+	}
+
+	if (imins >= 60)
+	{
+		imins = 0;
+		ideg++;
+	}
+
+	// Normalize the degrees to be in the range [0,359]
+	ideg %= 360;
+
+	// Make sure that the sign is there.
+	char* p = buf;
+	if (sdeg < 0.0)
+		*p++ = '-';
+
+	p += FormatUInt32(p, ideg);
+	*p++ = '-';
+	p += FormatUInt32(p, imins);
+
+	// Append seconds if they'll show.
+	if (msecs > 0)
+	{
+		*p++ = '-';
+		p += FormatUInt32(p, msecs / 1000);
+		*p++ = '.';
+		p[0] = (char)('0' + (msecs / 100) % 10);
+		FormatTwoDigits(p+1, msecs % 100);
+		p += 3;
+	}
+
+	if (isDeflection)
+		*p++ = 'd';
+
+	return (unsigned int)(p - buf);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// Converts numbers to text without going through sprintf. Each method writes into a
+// caller-supplied buffer (which must have room for at least MaxLength characters),
+// and returns the number of characters written. The result is not null-terminated.
+// The text matches what sprintf would produce for the corresponding format.
+class NumberFormatter
+{
+public:
+	static const unsigned int MaxLength = 32;
+
+	static unsigned int FormatInt32(char* buf, int value);					// %d
+	static unsigned int FormatUInt32(char* buf, unsigned int value);		// %u
+	static unsigned int FormatInt64(char* buf, __int64 value);				// %I64d
+	static unsigned int FormatUInt64(char* buf, unsigned __int64 value);	// %I64u
+	static unsigned int FormatFixed6(char* buf, double value);				// %f
+
+	// The most characters that FormatFixed6 could produce for a value (anything under a
+	// billion fits in 18 characters, but "%f" never uses an exponent for larger values)
+	static unsigned int GetMaxFixed6Length(double value)
+	{
+		return (value > -1.0e9 && value < 1.0e9 ? 18 : 320);
+	}
+
+	// Writes vertices as "x y,x y,..." (each value formatted with "%f"). The buffer must
+	// have room for GetMaxLineStringLength characters.
+	static unsigned int FormatLineString(char* buf, const double* xy, unsigned int numVertex);
+	static unsigned int GetMaxLineStringLength(const double* xy, unsigned int numVertex);
+
+	// Writes values separated by semicolons, each formatted with "%d" (so unsigned values
+	// that are too big for an int come out negative). The buffer must have room for 12
+	// characters per value.
+	template <class T> static unsigned int FormatList(char* buf, const T* values, unsigned int n)
+	{
+		char* p = buf;
+
+		for (unsigned int i=0; i<n; i++)
+		{
+			if (i > 0)
+				*p++ = ';';
+
+			p += FormatInt32(p, (int)values[i]);
+		}
+
+		return (unsigned int)(p - buf);
+	}
+
+	// Writes an angle in radians as "[-]deg-min[-sec.sss][d]" (the same short form as
+	// RadianValue.AsShortString in Backsight.Editor). Whole seconds are left out when they
+	// would display as zero, and a trailing "d" marks a deflection angle.
+	static unsigned int FormatRadians(char* buf, double value, bool isDeflection);
+
+	// Writes exactly two digits (with a leading zero if necessary)
+	static void FormatTwoDigits(char* buf, unsigned int value)
+	{
+		buf[0] = (char)('0' + (value / 10) % 10);
+		buf[1] = (char)('0' + value % 10);
+	}
+};
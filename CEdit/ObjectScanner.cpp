@@ -0,0 +1,103 @@
+#include "StdAfx.h"
+#include <assert.h>
+
+#ifdef _CEDIT
+#include "CeMap.h"
+#include "CeObjectList.h"
+#endif
+
+#include "ObjectScanner.h"
+
+// Passes every object in the CED file to each consumer, returning the number of objects
+unsigned int ObjectScanner::Run()
+{
+	unsigned int numObject = 0;
+	int nc = m_Consumers.GetSize();
+
+	for (int i=0; i<nc; i++)
+		((ObjectConsumer*)m_Consumers.GetAt(i))->Start();
+
+#ifdef _CEDIT
+	void* ptr=0;
+	os_typespec* curts=0;
+	os_int32 count=0;
+	os_object_cursor c(os_database::of(m_CedFile));
+
+	for ( c.first(); c.more(); c.next() )
+	{
+		if ( c.current(ptr,curts,count) )
+		{
+			numObject++;
+
+			for (int i=0; i<nc; i++)
+				((ObjectConsumer*)m_Consumers.GetAt(i))->Consume(ptr, (int)count);
+		}
+	}
+#endif
+
+	for (int i=0; i<nc; i++)
+		((ObjectConsumer*)m_Consumers.GetAt(i))->Finish();
+
+	return numObject;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+ObjectListValidator::ObjectListValidator(const ValidObjectIndex& validObjects)
+	: m_ValidObjects(validObjects)
+{
+	m_NumCheck = 0;
+	m_NumSkip = 0;
+	m_NumBad = 0;
+	m_ListItems.SetSize(0, 64*1024);
+}
+
+void ObjectListValidator::Consume(void* ptr, int count)
+{
+#ifdef _CEDIT
+	if (count > 1)
+		return;
+
+	m_NumCheck++;
+	CeClass* pc = (CeClass*)ptr;
+	objectstore::touch(pc, false);
+
+	// Objects that are known to be bad
+	if (ptr == (void*)0x3039a900 ||
+		ptr == (void*)0x30399b88 ||
+		ptr == (void*)0x30399660 ||
+		ptr == (void*)0x303988c0 ||
+		ptr == (void*)0x30398df8)
+	{
+		m_NumSkip++;
+		return;
+	}
+
+	CeObjectList* pList = dynamic_cast<CeObjectList*>(pc);
+	if (pList)
+	{
+		CeFixedArray<CeClass*> stuff(*pList);
+		UINT4 numobj = stuff.GetCount();
+
+		for ( UINT4 i=0; i<numobj; i++ )
+			m_ListItems.Add((void*)stuff[i]);
+	}
+#endif
+}
+
+void ObjectListValidator::Finish()
+{
+	for (int i=0; i<m_ListItems.GetSize(); i++)
+	{
+		if (!m_ValidObjects.IsValid(m_ListItems.GetAt(i)))
+			m_NumBad++;
+	}
+
+	m_ListItems.RemoveAll();
+}
+
+void ObjectListValidator::GetSummary(CString& s) const
+{
+	s.Format("Number of objects=%u\nNumber of bad refs=%u (nCheck=%u) (nSkip=%u)",
+		m_ValidObjects.GetCount(), m_NumBad, m_NumCheck, m_NumSkip);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "PtrIdTable.h"
+
+#ifdef _CEDIT
+class CeMap;
+#else
+#include "CEditStubs.h"
+#endif
+
+// Something that wants to see every object in a CED file
+class ObjectConsumer
+{
+public:
+	virtual ~ObjectConsumer() {}
+
+	// Called before the first object is passed to Consume
+	virtual void Start() {}
+
+	// Called for each object in the database. The count is the number of objects at the
+	// address (greater than 1 if the object is an array).
+	virtual void Consume(void* ptr, int count) = 0;
+
+	// Called after the last object has been passed to Consume
+	virtual void Finish() {}
+};
+
+// Walks through every object in a CED file, passing each one to a set of consumers. Scanning
+// a large database takes a long time (it's dominated by page faults), so this makes it possible
+// for everything that needs to see every object to share a single pass.
+class ObjectScanner
+{
+public:
+	ObjectScanner(CeMap* cedFile) : m_CedFile(cedFile) {}
+
+	void Add(ObjectConsumer* consumer) { m_Consumers.Add(consumer); }
+	unsigned int Run();
+
+private:
+	CeMap* m_CedFile;
+	CPtrArray m_Consumers;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Records the address of every object in a CED file
+class ValidObjectIndex : public ObjectConsumer
+{
+public:
+	ValidObjectIndex() : m_Objects(64*1024) {}
+
+	void Consume(void* ptr, int count) { m_Objects.SetAt(ptr, 1); }
+
+	bool IsValid(const void* ptr) const
+	{
+		unsigned int junk;
+		return (ptr != 0 && m_Objects.Lookup(ptr, junk));
+	}
+
+	unsigned int GetCount() const { return m_Objects.GetCount(); }
+
+private:
+	PtrIdTable m_Objects;
+};
+
+// Checks whether the object lists in a CED file refer to anything that isn't in the
+// database. The elements of each list are noted while the database is being scanned, and
+// checked once the scan is finished (when the index of valid objects is complete).
+class ObjectListValidator : public ObjectConsumer
+{
+public:
+	ObjectListValidator(const ValidObjectIndex& validObjects);
+
+	void Consume(void* ptr, int count);
+	void Finish();
+	void GetSummary(CString& s) const;
+
+private:
+	const ValidObjectIndex& m_ValidObjects;
+
+	// The objects referred to by lists
+	CPtrArray m_ListItems;
+
+	unsigned int m_NumCheck;
+	unsigned int m_NumSkip;
+	unsigned int m_NumBad;
+};
@@ -0,0 +1,80 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include "OutputBuffer.h"
+
+OutputBuffer::OutputBuffer(FILE* fp, unsigned int size)
+{
+	assert(size > 0);
+
+	m_File = fp;
+	m_Data = (char*)malloc(size);
+	if (m_Data == 0)
+		AfxThrowMemoryException();
+
+	m_Size = size;
+	m_Length = 0;
+	m_Flushed = 0;
+}
+
+OutputBuffer::OutputBuffer()
+{
+	m_File = 0;
+	m_Data = 0;
+	m_Size = 0;
+	m_Length = 0;
+	m_Flushed = 0;
+}
+
+OutputBuffer::~OutputBuffer()
+{
+	Flush();
+	free(m_Data);
+}
+
+// Appends data to the buffer. Anything bigger than the buffer itself goes straight to the file.
+void OutputBuffer::Append(const char* data, unsigned int n)
+{
+	if (m_Length + n > m_Size && n >= m_Size && m_File != 0)
+	{
+		Flush();
+		fwrite(data, 1, n, m_File);
+		m_Flushed += n;
+		return;
+	}
+
+	memcpy(Reserve(n), data, n);
+	m_Length += n;
+}
+
+// Writes out anything that is currently buffered
+void OutputBuffer::Flush()
+{
+	if (m_Length > 0 && m_File != 0)
+	{
+		fwrite(m_Data, 1, m_Length, m_File);
+		m_Flushed += m_Length;
+		m_Length = 0;
+	}
+}
+
+// Ensures there are at least n bytes of free space at the end of the buffer
+void OutputBuffer::MakeRoom(unsigned int n)
+{
+	Flush();
+
+	// If a single request is bigger than the buffer, let the buffer grow
+	if (m_Length + n > m_Size)
+	{
+		unsigned int newSize = m_Size;
+		while (m_Length + n > newSize)
+			newSize *= 2;
+
+		// If realloc fails, the old block is left as it was (and gets freed by the destructor)
+		char* data = (char*)realloc(m_Data, newSize);
+		if (data == 0)
+			AfxThrowMemoryException();
+
+		m_Data = data;
+		m_Size = newSize;
+	}
+}
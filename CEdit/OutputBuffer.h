@@ -0,0 +1,50 @@
+#pragma once
+
+// Accumulates output in a large block of memory, passing it on to a file only when
+// the block fills up (or when Flush is called). This avoids the per-call locking and
+// format parsing that comes with writing each item through stdio. If the buffer isn't
+// associated with a file, it just grows to hold everything that's written.
+class OutputBuffer
+{
+public:
+	static const unsigned int DefaultSize = 4*1024*1024;
+
+	OutputBuffer(FILE* fp, unsigned int size = DefaultSize);
+	virtual ~OutputBuffer();
+
+	// Obtains a pointer to at least n bytes of free space. Once the space has been
+	// filled, call Commit to say how much of it was actually used.
+	char* Reserve(unsigned int n)
+	{
+		if (m_Length + n > m_Size)
+			MakeRoom(n);
+
+		return m_Data + m_Length;
+	}
+
+	void Commit(unsigned int n) { m_Length += n; }
+	void Append(const char* data, unsigned int n);
+	void Append(char c) { *Reserve(1) = c; m_Length++; }
+
+	virtual void Flush();
+
+	// The data that has not been flushed yet (for a buffer that isn't associated with
+	// a file, that's everything that has been written)
+	const char* GetData() const { return m_Data; }
+	unsigned int GetLength() const { return m_Length; }
+
+	// The total number of bytes written so far (including anything not yet flushed)
+	unsigned __int64 GetTotalBytes() const { return m_Flushed + m_Length; }
+
+protected:
+	// For derived classes that supply their own memory (nothing gets allocated)
+	OutputBuffer();
+
+	virtual void MakeRoom(unsigned int n);
+
+	FILE* m_File;
+	char* m_Data;
+	unsigned int m_Size;
+	unsigned int m_Length;
+	unsigned __int64 m_Flushed;
+};
@@ -0,0 +1,195 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include <process.h>
+#include "OutputBuffer.h"
+#include "IEditWriter.h"
+#include "EditSerializer.h"
+#include "Changes.h"
+#include "CedExporter.h"
+#include "ExportIndex.h"
+#include "ParallelSerializer.h"
+
+// Works out how many threads to use (0 means one per processor)
+// static
+unsigned int ParallelSerializer::GetNumThread(unsigned int requested)
+{
+	if (requested == 0)
+	{
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		requested = si.dwNumberOfProcessors;
+	}
+
+	// The workers are waited on all at once
+	if (requested > MAXIMUM_WAIT_OBJECTS)
+		requested = MAXIMUM_WAIT_OBJECTS;
+
+	return requested;
+}
+
+ParallelSerializer::ParallelSerializer(const IdFactory& idFactory, const ExportOptions& options, unsigned int numThread)
+	: m_IdFactory(idFactory)
+	, m_Options(options)
+{
+	assert(numThread > 0 && numThread <= MAXIMUM_WAIT_OBJECTS);
+	m_NumThread = numThread;
+	m_Items = 0;
+	m_Chunks = 0;
+	m_NumChunk = 0;
+	m_NextChunk = 0;
+	m_Quit = false;
+	m_NumBusy = 0;
+
+	LONG window = 4 * numThread;
+	m_Window = CreateSemaphore(0, window, window, 0);
+	m_Start = CreateSemaphore(0, 0, numThread, 0);
+	m_BatchDone = CreateEvent(0, FALSE, FALSE, 0);
+
+	m_NumStarted = 0;
+	for (unsigned int t=0; t<numThread; t++)
+	{
+		HANDLE h = (HANDLE)_beginthreadex(0, 0, WorkerProc, this, 0, 0);
+		if (h != 0)
+			m_Threads[m_NumStarted++] = h;
+	}
+}
+
+ParallelSerializer::~ParallelSerializer()
+{
+	if (m_NumStarted > 0)
+	{
+		m_Quit = true;
+		ReleaseSemaphore(m_Start, m_NumStarted, 0);
+		WaitForMultipleObjects(m_NumStarted, m_Threads, TRUE, INFINITE);
+
+		for (unsigned int t=0; t<m_NumStarted; t++)
+			CloseHandle(m_Threads[t]);
+	}
+
+	CloseHandle(m_BatchDone);
+	CloseHandle(m_Start);
+	CloseHandle(m_Window);
+}
+
+// Formats a range of items (from start up to, but not including, end), appending the
+// result to the output buffer. If an index is supplied, it gets told where each item ends
+// up in the output.
+void ParallelSerializer::Write(const CPtrArray& items, int start, int end, OutputBuffer& output, ExportIndex* index)
+{
+	m_Items = &items;
+	m_NumChunk = (end - start + ChunkSize - 1) / ChunkSize;
+	m_NextChunk = 0;
+	m_Chunks = new Chunk[m_NumChunk];
+
+	for (LONG i=0; i<m_NumChunk; i++)
+	{
+		Chunk& c = m_Chunks[i];
+		c.Start = start + i * ChunkSize;
+		c.End = min(c.Start + ChunkSize, end);
+		c.Output = 0;
+		c.Offsets = new unsigned int[c.End - c.Start];
+		c.Done = CreateEvent(0, TRUE, FALSE, 0);
+	}
+
+	// Wake up the workers
+	if (m_NumStarted > 0)
+	{
+		m_NumBusy = m_NumStarted;
+		ReleaseSemaphore(m_Start, m_NumStarted, 0);
+	}
+
+	// Append each chunk as soon as it's ready, and let the workers move on
+	for (LONG i=0; i<m_NumChunk; i++)
+	{
+		Chunk& c = m_Chunks[i];
+
+		// With no workers, each chunk gets formatted here instead
+		if (m_NumStarted == 0)
+			FormatChunk(c);
+		else
+			WaitForSingleObject(c.Done, INFINITE);
+
+		if (index != 0)
+		{
+			unsigned __int64 base = output.GetTotalBytes();
+			for (int j=c.Start; j<c.End; j++)
+				index->AddItem(*(const Persistent_c*)items.GetAt(j), base + c.Offsets[j - c.Start]);
+		}
+
+		output.Append(c.Output->GetData(), c.Output->GetLength());
+
+		delete c.Output;
+		c.Output = 0;
+		delete [] c.Offsets;
+		c.Offsets = 0;
+		CloseHandle(c.Done);
+		ReleaseSemaphore(m_Window, 1, 0);
+	}
+
+	// Don't let go of the chunks until every worker is done looking at them
+	if (m_NumStarted > 0)
+		WaitForSingleObject(m_BatchDone, INFINITE);
+
+	delete [] m_Chunks;
+	m_Chunks = 0;
+	m_Items = 0;
+}
+
+// static
+unsigned __stdcall ParallelSerializer::WorkerProc(void* arg)
+{
+	((ParallelSerializer*)arg)->RunWorker();
+	return 0;
+}
+
+// Takes part in each batch of chunks, until the serializer is deleted
+void ParallelSerializer::RunWorker()
+{
+	for (;;)
+	{
+		WaitForSingleObject(m_Start, INFINITE);
+		if (m_Quit)
+			return;
+
+		RunBatch();
+
+		if (InterlockedDecrement(&m_NumBusy) == 0)
+			SetEvent(m_BatchDone);
+	}
+}
+
+// Formats chunks until there are none left in the current batch
+void ParallelSerializer::RunBatch()
+{
+	for (;;)
+	{
+		WaitForSingleObject(m_Window, INFINITE);
+
+		LONG i = InterlockedIncrement(&m_NextChunk) - 1;
+		if (i >= m_NumChunk)
+		{
+			// Pass on the slot so that any other waiting worker also gets to finish
+			ReleaseSemaphore(m_Window, 1, 0);
+			return;
+		}
+
+		FormatChunk(m_Chunks[i]);
+		SetEvent(m_Chunks[i].Done);
+	}
+}
+
+void ParallelSerializer::FormatChunk(Chunk& c)
+{
+	c.Output = new OutputBuffer(0, 64*1024);
+	IEditWriter* writer = CedExporter::CreateEditWriter(m_Options.Format, c.Output);
+	EditSerializer es(m_IdFactory, *writer, m_Options.CompactLines);
+
+	for (int i=c.Start; i<c.End; i++)
+	{
+		const Persistent_c* p = (const Persistent_c*)m_Items->GetAt(i);
+		c.Offsets[i - c.Start] = c.Output->GetLength();
+		es.WritePersistent(DataField_Edit, *p);
+	}
+
+	delete writer;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ExportOptions.h"
+
+class IdFactory;
+class OutputBuffer;
+class ExportIndex;
+
+// Formats export items using a set of worker threads. The items are divided into chunks
+// of consecutive items, and each chunk is formatted into a buffer of its own. The buffers
+// are then appended to the output in sequence, so the result is exactly the same as
+// serializing the items one after another on a single thread.
+//
+// This relies on every item having been fully constructed beforehand (so that all IDs have
+// been allocated), since the workers share the IdFactory, and only ever read from it.
+//
+// The worker threads are started when the serializer is created, and they stay around
+// (waiting for the next call to Write) until it is deleted. If a thread can't be started,
+// the work gets shared among the ones that did start (or, if none did, it's all done on
+// the calling thread).
+class ParallelSerializer
+{
+public:
+	// The number of items in each chunk
+	static const int ChunkSize = 256;
+
+	static unsigned int GetNumThread(unsigned int requested);
+
+	ParallelSerializer(const IdFactory& idFactory, const ExportOptions& options, unsigned int numThread);
+	~ParallelSerializer();
+
+	void Write(const CPtrArray& items, int start, int end, OutputBuffer& output, ExportIndex* index = 0);
+
+private:
+	struct Chunk
+	{
+		int Start;				// Index of the first item in the chunk
+		int End;				// Index after the last item in the chunk
+		OutputBuffer* Output;	// The formatted items
+		unsigned int* Offsets;	// Where each item starts in Output
+		HANDLE Done;			// Signalled once the chunk has been formatted
+	};
+
+	static unsigned __stdcall WorkerProc(void* arg);
+	void RunWorker();
+	void RunBatch();
+	void FormatChunk(Chunk& c);
+
+	const IdFactory& m_IdFactory;
+	const ExportOptions& m_Options;
+	unsigned int m_NumThread;
+
+	// The workers that were actually started
+	HANDLE m_Threads[MAXIMUM_WAIT_OBJECTS];
+	unsigned int m_NumStarted;
+
+	// Each call to Write lets every worker in on the batch by releasing this once per
+	// worker (when the serializer is deleted, it's released with m_Quit set instead)
+	HANDLE m_Start;
+	volatile bool m_Quit;
+
+	// The number of workers that haven't yet finished with the current batch (the last one
+	// to finish signals m_BatchDone)
+	volatile LONG m_NumBusy;
+	HANDLE m_BatchDone;
+
+	const CPtrArray* m_Items;
+	Chunk* m_Chunks;
+	LONG m_NumChunk;
+
+	// The index of the next chunk that needs to be formatted
+	volatile LONG m_NextChunk;
+
+	// Limits how far the workers can get ahead of the chunks that have been written
+	// (so that the whole file doesn't end up being held in memory)
+	HANDLE m_Window;
+};
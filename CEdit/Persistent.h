@@ -1,18 +1,26 @@
 #pragma once
 
+#include "ExportArena.h"
+
 class EditSerializer;
 
 // Abstract base class for everything
 class Persistent_c
 {
 public:
+	virtual ~Persistent_c() {}
+
+	// Export objects are placed in the current export arena (if any)
+	static void* operator new(size_t size) { return ExportArena::AllocateObject(size); }
+	static void operator delete(void* p) { ExportArena::FreeObject(p); }
+
 	virtual LPCTSTR GetTypeName() const = 0;
 	virtual void WriteData(EditSerializer& s) const = 0;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-class IdMapping_c : Persistent_c
+class IdMapping_c : public Persistent_c
 {
 public:
 	unsigned int InternalId;
@@ -27,7 +35,7 @@ public:
 
 //////////////////////////////////////////////////////////////////////////////////////////////////
 
-class LegFace_c : Persistent_c
+class LegFace_c : public Persistent_c
 {
 public:
 	unsigned int Id;
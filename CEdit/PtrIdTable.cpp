@@ -0,0 +1,154 @@
+#include "StdAfx.h"
+#include <assert.h>
+#include "PtrIdTable.h"
+
+// The table is grown once it gets more than 3/4 full. With Fibonacci hashing, linear
+// probing stays short at that load (a miss checks about 8 slots, which is still only a
+// couple of cache lines), and it takes 2/3 of the memory that a half full table would.
+static bool IsOverloaded(unsigned __int64 count, unsigned __int64 capacity)
+{
+	return (count*4 > capacity*3);
+}
+
+static unsigned int GetBitsFor(unsigned int count)
+{
+	unsigned int bits = 4;
+	while (bits < 31 && IsOverloaded(count, (unsigned __int64)1 << bits))
+		bits++;
+
+	return bits;
+}
+
+PtrIdTable::PtrIdTable(unsigned int initialCount)
+{
+	m_Count = 0;
+	Allocate(GetBitsFor(initialCount));
+}
+
+PtrIdTable::~PtrIdTable()
+{
+	free(m_Entries);
+}
+
+void PtrIdTable::Allocate(unsigned int bits)
+{
+	m_Bits = bits;
+	m_Mask = ((unsigned int)1 << bits) - 1;
+	m_Entries = (Entry*)calloc(m_Mask + 1, sizeof(Entry));
+}
+
+// Looks up the value associated with a key, returning false if the key isn't there
+bool PtrIdTable::Lookup(const void* key, unsigned int& value) const
+{
+	assert(key != 0);
+
+	for (unsigned int i = GetSlot(key); ; i = (i+1) & m_Mask)
+	{
+		const Entry& e = m_Entries[i];
+
+		if (e.Key == key)
+		{
+			value = e.Value;
+			return true;
+		}
+
+		if (e.Key == 0)
+			return false;
+	}
+}
+
+// Associates a value with a key (replacing any value that was previously there)
+void PtrIdTable::SetAt(const void* key, unsigned int value)
+{
+	assert(key != 0);
+
+	if (IsOverloaded(m_Count+1, (unsigned __int64)m_Mask+1))
+		Rehash(m_Bits+1);
+
+	for (unsigned int i = GetSlot(key); ; i = (i+1) & m_Mask)
+	{
+		Entry& e = m_Entries[i];
+
+		if (e.Key == key)
+		{
+			e.Value = value;
+			return;
+		}
+
+		if (e.Key == 0)
+		{
+			e.Key = key;
+			e.Value = value;
+			m_Count++;
+			return;
+		}
+	}
+}
+
+// Ensures the table can hold the specified number of entries without growing
+void PtrIdTable::Reserve(unsigned int count)
+{
+	unsigned int bits = GetBitsFor(count);
+	if (bits > m_Bits)
+		Rehash(bits);
+}
+
+void PtrIdTable::RemoveAll()
+{
+	memset(m_Entries, 0, (m_Mask+1) * sizeof(Entry));
+	m_Count = 0;
+}
+
+// Moves everything into a new array with 2^bits slots
+void PtrIdTable::Rehash(unsigned int bits)
+{
+	Entry* old = m_Entries;
+	unsigned int oldSize = m_Mask+1;
+	Allocate(bits);
+
+	for (unsigned int j=0; j<oldSize; j++)
+	{
+		if (old[j].Key != 0)
+		{
+			unsigned int i = GetSlot(old[j].Key);
+			while (m_Entries[i].Key != 0)
+				i = (i+1) & m_Mask;
+
+			m_Entries[i] = old[j];
+		}
+	}
+
+	free(old);
+}
+
+// The position is the array index of the next occupied slot, plus one (0 means there are no more)
+POSITION PtrIdTable::GetStartPosition() const
+{
+	for (unsigned int i=0; i<=m_Mask; i++)
+	{
+		if (m_Entries[i].Key != 0)
+			return (POSITION)(size_t)(i+1);
+	}
+
+	return 0;
+}
+
+void PtrIdTable::GetNextAssoc(POSITION& pos, void*& key, unsigned int& value) const
+{
+	unsigned int i = (unsigned int)(size_t)pos - 1;
+	assert(i <= m_Mask && m_Entries[i].Key != 0);
+
+	key = (void*)m_Entries[i].Key;
+	value = m_Entries[i].Value;
+
+	for (i++; i<=m_Mask; i++)
+	{
+		if (m_Entries[i].Key != 0)
+		{
+			pos = (POSITION)(size_t)(i+1);
+			return;
+		}
+	}
+
+	pos = 0;
+}
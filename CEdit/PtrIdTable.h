@@ -0,0 +1,48 @@
+#pragma once
+
+// A hash table that associates object pointers with 32-bit values. This takes the place
+// of CMapPtrToPtr for the indexes held by IdFactory, which can contain millions of
+// entries. Entries are held in a single array (open addressing with linear probing), so
+// a lookup usually touches just one cache line, and nothing gets allocated per entry.
+//
+// Null keys cannot be stored (a null key marks an empty slot), and entries cannot be
+// removed individually (only via RemoveAll).
+class PtrIdTable
+{
+public:
+	PtrIdTable(unsigned int initialCount = 1024);
+	~PtrIdTable();
+
+	bool Lookup(const void* key, unsigned int& value) const;
+	void SetAt(const void* key, unsigned int value);
+	void Reserve(unsigned int count);
+	void RemoveAll();
+
+	unsigned int GetCount() const { return m_Count; }
+
+	// Iteration in the style of the MFC collection classes
+	POSITION GetStartPosition() const;
+	void GetNextAssoc(POSITION& pos, void*& key, unsigned int& value) const;
+
+private:
+	struct Entry
+	{
+		const void* Key;
+		unsigned int Value;
+	};
+
+	unsigned int GetSlot(const void* key) const
+	{
+		// Fibonacci hashing (the top bits of the product are the best mixed)
+		unsigned __int64 k = (unsigned __int64)(size_t)key;
+		return (unsigned int)((k * 0x9E3779B97F4A7C15ull) >> (64 - m_Bits));
+	}
+
+	void Allocate(unsigned int bits);
+	void Rehash(unsigned int bits);
+
+	Entry* m_Entries;
+	unsigned int m_Bits;		// The capacity is 2^m_Bits
+	unsigned int m_Mask;		// The capacity less one
+	unsigned int m_Count;
+};
@@ -0,0 +1,168 @@
+#include "StdAfx.h"
+#include <stdio.h>
+#include "ExportState.h"
+#include "Test.h"
+
+// Checks that the state saved by one export gives a later export of the same map what it
+// needs. If nothing has changed, every feature and location gets back the ID it had. If the
+// features created by an edit now come out in a different order, the keys lead to the wrong
+// features, and that has to be noticed (CedExporter then does a full export instead).
+
+static LPCTSTR StateFileName = "ExportStateTest.state";
+
+// The features created by a few edits, as a scan of the map would find them
+struct SampleFeature
+{
+	unsigned int OpSequence;
+	unsigned int Ordinal;	// Position among the features created by the edit
+	unsigned int Check;		// What IdFactory::GetFeatureCheck would give for the feature
+	unsigned int Id;
+};
+
+static const SampleFeature SampleFeatures[] =
+{
+	{ 3, 0, 0x1111, 20 },
+	{ 3, 1, 0x2222, 21 },
+	{ 3, 2, 0x3333, 22 },
+	{ 7, 0, 0x1111, 40 },
+	{ 12, 0, 0x4444, 41 },
+	{ 12, 1, 0x1111, 42 },
+};
+
+static const unsigned int NumSampleFeature = sizeof(SampleFeatures) / sizeof(SampleFeatures[0]);
+
+// Saves the state from an export of the sample features (the features get added in a
+// different order from the scan, as they would when taken from a hash table)
+static bool SaveFirstExport()
+{
+	ExportState state;
+	state.MaxId = 100;
+	state.NumSession = 4;
+	state.LastSessionStart = 1234567890;
+	state.LastSessionOps = 17;
+
+	state.AddIdRange(1, 1, 50);
+	state.AddIdRange(2, 500, 599);
+
+	for (unsigned int i=NumSampleFeature; i>0; i--)
+	{
+		const SampleFeature& f = SampleFeatures[i-1];
+		state.AddFeature(f.OpSequence, f.Ordinal, f.Check, f.Id);
+	}
+
+	// Two coincident locations, and one on its own
+	state.AddLocation(500000.123456, 5500000.654321, 60);
+	state.AddLocation(500000.123456, 5500000.654321, 61);
+	state.AddLocation(-10.5, 20.25, 62);
+
+	return state.Save(StateFileName);
+}
+
+// A re-export of a map that hasn't changed (apart from an extra edit, and a range that has
+// been extended)
+static void CheckUnchanged(ExportState& previous)
+{
+	CHECK(previous.MaxId == 100);
+	CHECK(previous.NumSession == 4);
+	CHECK(previous.LastSessionStart == 1234567890);
+	CHECK(previous.LastSessionOps == 17);
+	CHECK(previous.GetNumFeature() == NumSampleFeature);
+	CHECK(previous.GetNumLocation() == 3);
+
+	for (unsigned int i=0; i<NumSampleFeature; i++)
+	{
+		const SampleFeature& f = SampleFeatures[i];
+		unsigned int id = 0;
+		CHECK(previous.MatchFeature(f.OpSequence, f.Ordinal, f.Check, id) == FeatureMatch_Same);
+		CHECK(id == f.Id);
+	}
+
+	// The features created by an edit that wasn't in the previous export
+	unsigned int id = 99;
+	CHECK(previous.MatchFeature(13, 0, 0x1111, id) == FeatureMatch_None);
+	CHECK(id == 0);
+	CHECK(previous.MatchFeature(3, 3, 0x1111, id) == FeatureMatch_None);
+
+	// Each coincident location gets one of the IDs (in either order), and no more
+	unsigned int id1 = previous.TakeLocation(500000.123456, 5500000.654321);
+	unsigned int id2 = previous.TakeLocation(500000.123456, 5500000.654321);
+	CHECK(id1 + id2 == 121 && id1 != id2);
+	CHECK(previous.TakeLocation(500000.123456, 5500000.654321) == 0);
+	CHECK(previous.TakeLocation(-10.5, 20.25) == 62);
+	CHECK(previous.TakeLocation(-10.5, 20.25) == 0);
+	CHECK(previous.TakeLocation(-10.5, 20.250002) == 0);
+
+	// Only the new part of an extended range needs to be written
+	CUIntArray parts;
+	previous.GetUnwrittenIdRanges(1, 1, 50, parts);
+	CHECK(parts.GetSize() == 0);
+
+	previous.GetUnwrittenIdRanges(1, 1, 80, parts);
+	CHECK(parts.GetSize() == 2 && parts.GetAt(0) == 51 && parts.GetAt(1) == 80);
+
+	parts.RemoveAll();
+	previous.GetUnwrittenIdRanges(3, 500, 599, parts);
+	CHECK(parts.GetSize() == 2 && parts.GetAt(0) == 500 && parts.GetAt(1) == 599);
+}
+
+// A re-export where the first edit's features get scanned in a different order, so each of
+// its keys now leads to some other feature
+static void CheckMismatched(const ExportState& previous)
+{
+	static const unsigned int scanned[] = { 2, 0, 1 };
+	unsigned int numSame = 0;
+	unsigned int numDifferent = 0;
+
+	for (unsigned int ordinal=0; ordinal<3; ordinal++)
+	{
+		const SampleFeature& f = SampleFeatures[scanned[ordinal]];
+		unsigned int id = 99;
+		FeatureMatch match = previous.MatchFeature(f.OpSequence, ordinal, f.Check, id);
+
+		if (match == FeatureMatch_Same)
+			numSame++;
+		else if (match == FeatureMatch_Different)
+			numDifferent++;
+
+		// A feature never gets the ID of a different one
+		CHECK(match == FeatureMatch_Different && id == 0);
+	}
+
+	CHECK(numSame == 0 && numDifferent == 3);
+
+	// The features created by the other edits are unaffected
+	unsigned int id = 0;
+	CHECK(previous.MatchFeature(12, 1, 0x1111, id) == FeatureMatch_Same && id == 42);
+}
+
+void TestExportState()
+{
+	CHECK(SaveFirstExport());
+
+	ExportState unchanged;
+	CHECK(unchanged.Load(StateFileName));
+	CheckUnchanged(unchanged);
+
+	ExportState mismatched;
+	CHECK(mismatched.Load(StateFileName));
+	CheckMismatched(mismatched);
+
+	// A file that has been cut short can't be used at all
+	FILE* fp = fopen(StateFileName, "rb");
+	char buf[1024];
+	size_t len = (fp == 0 ? 0 : fread(buf, 1, sizeof(buf), fp));
+	if (fp != 0)
+		fclose(fp);
+
+	if (len > 0 && (fp = fopen(StateFileName, "wb")) != 0)
+	{
+		fwrite(buf, 1, len-1, fp);
+		fclose(fp);
+	}
+
+	ExportState damaged;
+	CHECK(len > 0 && !damaged.Load(StateFileName));
+	CHECK(damaged.GetNumFeature() == 0 && damaged.GetNumLocation() == 0);
+
+	remove(StateFileName);
+}
@@ -0,0 +1,4 @@
+#include "StdAfx.h"
+#include "CeLocation.h"
+
+__int64 CeLocation::Tolerance = 0;
@@ -0,0 +1,34 @@
+#pragma once
+#include "CeTileId.h"
+
+// A stand-in for the CEdit class of the same name. Positions are held in microns (as
+// they are in CEdit). Two locations are equal if their eastings and northings both differ
+// by no more than Tolerance microns.
+
+class CeLocation
+{
+public:
+	static __int64 Tolerance;
+
+	CeLocation(__int64 easting, __int64 northing, CeTile* pTile)
+		: m_Easting(easting), m_Northing(northing)
+	{
+		m_TileId.SetpTile(pTile);
+	}
+
+	double GetEasting ( void ) const { return (double)m_Easting / 1000000.0; }
+	double GetNorthing ( void ) const { return (double)m_Northing / 1000000.0; }
+	const CeTileId& GetTileID ( void ) const { return m_TileId; }
+
+	bool operator== ( const CeLocation& rhs ) const
+	{
+		__int64 dx = m_Easting - rhs.m_Easting;
+		__int64 dy = m_Northing - rhs.m_Northing;
+		return (dx >= -Tolerance && dx <= Tolerance && dy >= -Tolerance && dy <= Tolerance);
+	}
+
+private:
+	__int64 m_Easting;
+	__int64 m_Northing;
+	CeTileId m_TileId;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include "CeTileData.h"
+
+// A stand-in for the CEdit class of the same name, holding the locations that fall
+// in the tile.
+
+class CeTile
+{
+public:
+	CeTile() : m_Data(0) {}
+
+	~CeTile()
+	{
+		for (CeTileData* td = m_Data.m_pTail; td != &m_Data; )
+		{
+			CeTileData* prev = td->m_pPrev;
+			delete td;
+			td = prev;
+		}
+	}
+
+	const CeTileData* const GetpTileData ( void ) const { return &m_Data; }
+
+	// Adds a location (which must remain in scope for the life of the tile)
+	void AddLocation ( const CeLocation* pLoc )
+	{
+		CeTileData* td = m_Data.m_pTail;
+		if (td->m_NumLoc == CeTileData::BlockSize)
+		{
+			td = new CeTileData(td);
+			m_Data.m_pTail = td;
+		}
+
+		td->m_Locations[td->m_NumLoc++] = pLoc;
+	}
+
+private:
+	CeTile(const CeTile&);
+	CeTile& operator=(const CeTile&);
+
+	CeTileData m_Data;
+};
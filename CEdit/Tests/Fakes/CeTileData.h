@@ -0,0 +1,27 @@
+#pragma once
+
+// A stand-in for the CEdit class of the same name. The locations in a tile are held in
+// a chain of fixed-size blocks. The first block in the chain also knows the last one.
+
+class CeLocation;
+
+class CeTileData
+{
+	friend class CeTile;
+
+public:
+	static const unsigned int BlockSize = 256;
+
+	CeTileData(CeTileData* pPrev) : m_pPrev(pPrev), m_pTail(this), m_NumLoc(0) {}
+
+	const CeTileData* GetpTail ( void ) const { return m_pTail; }
+	const CeTileData* GetpPrev ( void ) const { return m_pPrev; }
+	unsigned int GetNumLoc ( void ) const { return m_NumLoc; }
+	const CeLocation** GetpLocations ( void ) const { return (const CeLocation**)m_Locations; }
+
+private:
+	CeTileData* m_pPrev;
+	CeTileData* m_pTail;
+	unsigned int m_NumLoc;
+	const CeLocation* m_Locations[BlockSize];
+};
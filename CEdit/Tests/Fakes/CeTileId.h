@@ -0,0 +1,17 @@
+#pragma once
+
+// A stand-in for the CEdit class of the same name, for testing LocationIndex without
+// the object store. Only the members used by LocationIndex are provided.
+
+class CeTile;
+
+class CeTileId
+{
+public:
+	CeTileId() : m_pTile(0) {}
+	CeTile* GetpTile ( void ) const { return m_pTile; }
+	void SetpTile ( CeTile* pTile ) { m_pTile = pTile; }
+
+private:
+	CeTile* m_pTile;
+};
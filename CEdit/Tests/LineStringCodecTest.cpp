@@ -0,0 +1,140 @@
+#include "StdAfx.h"
+#include "LineStringCodec.h"
+#include "Test.h"
+
+// Checks that LineStringCodec::Decode gives back what Encode was given, and that it
+// rejects data that isn't properly formed (without reading past the end of it).
+
+// A line with 4 vertices, and the bytes it should encode to. MultiSegmentGeometryTest
+// (in Backsight.Editor.Tests) decodes the same bytes, so change both if this changes.
+static const __int64 SampleLine[] = { 1000, 2000, 1063, 1936, 1064, 1872, -1000000, 5 };
+static const byte SampleData[] = { 0x04, 0xD0, 0x0F, 0xA0, 0x1F, 0x7E, 0x7F, 0x02, 0x7F,
+								   0xCF, 0x99, 0x7A, 0x95, 0x1D };
+
+static const __int64 MaxValue = 0x7FFFFFFFFFFFFFFFLL;
+static const __int64 MinValue = -MaxValue - 1;
+
+// Encodes a line, then checks that it decodes to the same thing. Returns the number of
+// bytes in the encoded line.
+static unsigned int CheckRoundTrip(const __int64* xy, unsigned int numVertex)
+{
+	byte* buf = new byte[LineStringCodec::GetMaxLength(numVertex)];
+	unsigned int len = LineStringCodec::Encode(buf, xy, numVertex);
+	CHECK(len <= LineStringCodec::GetMaxLength(numVertex));
+
+	unsigned int n;
+	__int64* result = LineStringCodec::Decode(buf, len, n);
+	CHECK(result != 0 && n == numVertex);
+
+	if (result != 0 && n == numVertex)
+		CHECK(memcmp(result, xy, numVertex * 2 * sizeof(__int64)) == 0);
+
+	delete [] result;
+	delete [] buf;
+	return len;
+}
+
+// Checks that Decode rejects the first "length" bytes of some data. The data that follows
+// is left in place, so if Decode read past the end of what it was given, it would be
+// likely to succeed.
+static void CheckRejected(const byte* data, unsigned int length)
+{
+	unsigned int n = 123;
+	__int64* result = LineStringCodec::Decode(data, length, n);
+	CHECK(result == 0 && n == 0);
+	delete [] result;
+}
+
+void TestLineStringCodec()
+{
+	// The sample line
+	CHECK(CheckRoundTrip(SampleLine, 4) == sizeof(SampleData));
+
+	byte buf[64];
+	unsigned int len = LineStringCodec::Encode(buf, SampleLine, 4);
+	CHECK(len == sizeof(SampleData) && memcmp(buf, SampleData, len) == 0);
+
+	// No vertices, and just one
+	CHECK(CheckRoundTrip(SampleLine, 0) == 1);
+	CHECK(CheckRoundTrip(SampleLine, 1) == 5);
+
+	__int64 origin[] = { 0, 0 };
+	CHECK(CheckRoundTrip(origin, 1) == 3);
+
+	// Deltas either side of each change in the width of the varints. With zigzag encoding,
+	// a delta of d (d >= 0) becomes 2d, and -d becomes 2d-1.
+	for (unsigned int width=1; width<10; width++)
+	{
+		__int64 limit = (__int64)1 << (7*width - 1);
+
+		for (int sign=-1; sign<=1; sign+=2)
+		{
+			// The largest delta that fits in the width (-limit for negatives), then the
+			// next one out
+			__int64 fits = (sign > 0 ? limit - 1 : -limit);
+			__int64 next = fits + sign;
+
+			__int64 xy[] = { fits, 0 };
+			CHECK(CheckRoundTrip(xy, 1) == 1 + width + 1);
+
+			xy[0] = next;
+			CHECK(CheckRoundTrip(xy, 1) == 1 + (width + 1) + 1);
+		}
+	}
+
+	// The largest deltas there are (the subtraction wraps)
+	__int64 extremes[] = { MaxValue, MinValue, MinValue, MaxValue, 0, 0, MaxValue, MaxValue,
+						   MinValue, MinValue, -1, 1, MaxValue, -1 };
+	CheckRoundTrip(extremes, 7);
+
+	__int64 minFromOrigin[] = { MinValue, MinValue };
+	CHECK(CheckRoundTrip(minFromOrigin, 1) == 1 + 10 + 10);
+
+	// A longer line, with vertices that are anything from close together to far apart
+	const unsigned int numVertex = 10000;
+	__int64* xy = new __int64[2 * numVertex];
+	unsigned int seed = 1;
+
+	for (unsigned int i=0; i<2*numVertex; i++)
+	{
+		seed = seed * 1664525 + 1013904223;
+		__int64 step = (__int64)(seed >> 8) - (1 << 23);
+		xy[i] = step * ((__int64)1 << (seed % 40));
+	}
+
+	CheckRoundTrip(xy, numVertex);
+	delete [] xy;
+
+	// Data that's been cut short
+	for (unsigned int i=0; i<sizeof(SampleData); i++)
+		CheckRejected(SampleData, i);
+
+	// Data with something extra on the end
+	byte extra[sizeof(SampleData)+1];
+	memcpy(extra, SampleData, sizeof(SampleData));
+	extra[sizeof(SampleData)] = 0;
+	CheckRejected(extra, sizeof(extra));
+
+	// More vertices than there's room for
+	byte tooMany[sizeof(SampleData)];
+	memcpy(tooMany, SampleData, sizeof(SampleData));
+	tooMany[0] = 7;
+	CheckRejected(tooMany, sizeof(tooMany));
+
+	byte hugeCount[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x0F, 0, 0 };
+	CheckRejected(hugeCount, sizeof(hugeCount));
+
+	// Varints that are too big to fit in 64 bits. The biggest there is takes 10 bytes,
+	// with just the low bit set in the last one.
+	byte maxVarint[] = { 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01, 0x00 };
+	unsigned int n;
+	__int64* result = LineStringCodec::Decode(maxVarint, sizeof(maxVarint), n);
+	CHECK(result != 0 && n == 1 && result[0] == MinValue && result[1] == 0);
+	delete [] result;
+
+	byte overflow[] = { 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x03, 0x00 };
+	CheckRejected(overflow, sizeof(overflow));
+
+	byte tooLong[] = { 0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00 };
+	CheckRejected(tooLong, sizeof(tooLong));
+}
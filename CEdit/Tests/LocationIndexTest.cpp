@@ -0,0 +1,157 @@
+#include "StdAfx.h"
+#include <stdlib.h>
+#include "CeTile.h"
+#include "CeTileId.h"
+#include "CeTileData.h"
+#include "CeLocation.h"
+#include "LocationIndex.h"
+#include "Test.h"
+
+// Checks that LocationIndex finds exactly the same coincident locations as a linear scan
+// of the tile. The locations come in small clusters (so there's something to find), with
+// many of them close to the edges of the index cells, and on both sides of the origin.
+// The scan is repeated with CeLocation::operator== matching over distances up to 1mm
+// (the limit that LocationIndex relies on).
+
+static const unsigned int NumTile = 3;
+static const unsigned int NumCluster = 2000;
+
+// A small random number generator, so that every run uses the same positions
+static unsigned int NextRandom(unsigned int& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+// A random offset (in microns) of up to 1.2mm either way, favouring the values where
+// matches start and stop
+static __int64 GetOffset(unsigned int& seed)
+{
+	static const __int64 edges[] = { 0, 1, -1, 250, -250, 251, 999, 1000, -1000, 1001, -1001 };
+	unsigned int r = NextRandom(seed);
+
+	if (r % 2 == 0)
+		return edges[(r/2) % (sizeof(edges)/sizeof(edges[0]))];
+
+	return (__int64)((r/2) % 2401) - 1200;
+}
+
+// A random position (in microns) within 2km of the origin. A third of them are within
+// a micron of the edge of an index cell.
+static __int64 GetBase(unsigned int& seed)
+{
+	unsigned int r = NextRandom(seed);
+	__int64 v = (__int64)(r % 4000000) * 1000 - 2000000000 + (__int64)(NextRandom(seed) % 1000);
+
+	if (r % 3 == 0)
+		v = (v / 1000) * 1000 + (__int64)(NextRandom(seed) % 3) - 1;
+
+	return v;
+}
+
+static int ComparePtr(const void* a, const void* b)
+{
+	size_t pa = (size_t)(*(void**)a);
+	size_t pb = (size_t)(*(void**)b);
+	return (pa < pb ? -1 : (pa > pb ? 1 : 0));
+}
+
+static void SortPtrs(CPtrArray& a)
+{
+	if (a.GetSize() > 1)
+		qsort(a.GetData(), a.GetSize(), sizeof(void*), ComparePtr);
+}
+
+void TestLocationIndex()
+{
+	CeTile tiles[NumTile];
+	CPtrArray tileLocs[NumTile];
+	unsigned int seed = 12345;
+
+	for (unsigned int t=0; t<NumTile; t++)
+	{
+		for (unsigned int c=0; c<NumCluster; c++)
+		{
+			__int64 e = GetBase(seed);
+			__int64 n = GetBase(seed);
+			unsigned int nLoc = 1 + NextRandom(seed) % 4;
+
+			for (unsigned int i=0; i<nLoc; i++)
+			{
+				CeLocation* loc = new CeLocation(e + GetOffset(seed), n + GetOffset(seed), &tiles[t]);
+				tiles[t].AddLocation(loc);
+				tileLocs[t].Add(loc);
+			}
+
+			// Put some of the positions in the next tile as well (they shouldn't get found
+			// when looking in this tile)
+			if (c % 10 == 0 && t+1 < NumTile)
+			{
+				CeLocation* loc = new CeLocation(e, n, &tiles[t+1]);
+				tiles[t+1].AddLocation(loc);
+				tileLocs[t+1].Add(loc);
+			}
+		}
+	}
+
+	unsigned int numLoc = 0;
+	for (unsigned int t=0; t<NumTile; t++)
+		numLoc += (unsigned int)tileLocs[t].GetSize();
+
+	static const __int64 tolerances[] = { 0, 1, 250, 1000 };
+
+	for (unsigned int k=0; k<sizeof(tolerances)/sizeof(tolerances[0]); k++)
+	{
+		CeLocation::Tolerance = tolerances[k];
+		LocationIndex index;
+		unsigned int numShared = 0;
+
+		for (unsigned int t=0; t<NumTile; t++)
+		{
+			const CPtrArray& locs = tileLocs[t];
+
+			for (int i=0; i<locs.GetSize(); i++)
+			{
+				const CeLocation* loc = (const CeLocation*)locs.GetAt(i);
+
+				CPtrArray found;
+				index.GetCoincidentLocations(loc, found);
+
+				CPtrArray expected;
+				for (int j=0; j<locs.GetSize(); j++)
+				{
+					if (*loc == *(const CeLocation*)locs.GetAt(j))
+						expected.Add(locs.GetAt(j));
+				}
+
+				SortPtrs(found);
+				SortPtrs(expected);
+
+				CHECK(found.GetSize() == expected.GetSize());
+				for (int j=0; j<found.GetSize() && j<expected.GetSize(); j++)
+					CHECK(found.GetAt(j) == expected.GetAt(j));
+
+				if (expected.GetSize() > 1)
+					numShared++;
+			}
+		}
+
+		// Make sure there really were coincident locations to find
+		CHECK(numShared > 0);
+
+		CHECK(index.GetNumTile() == NumTile);
+		CHECK(index.GetNumLoc() == numLoc);
+
+		CPtrArray none;
+		index.GetCoincidentLocations(0, none);
+		CHECK(none.GetSize() == 0);
+	}
+
+	CeLocation::Tolerance = 0;
+
+	for (unsigned int t=0; t<NumTile; t++)
+	{
+		for (int i=0; i<tileLocs[t].GetSize(); i++)
+			delete (CeLocation*)tileLocs[t].GetAt(i);
+	}
+}
@@ -0,0 +1,157 @@
+#include "StdAfx.h"
+#include <math.h>
+#include "NumberFormatter.h"
+#include "Test.h"
+
+// Checks that NumberFormatter::FormatRadians produces exactly what the old sprintf-based
+// code did (RadiansAsShortString, kept in RadiansReference.cpp). Angles are swept over
+// more than a full circle either way, with extra attention to the places where the old
+// code made decisions: seconds that carry into the minutes (59.999 and up), seconds that
+// are too small to show (under 0.001), and seconds that lie on a half millisecond (where
+// FormatRadians falls back on sprintf to get the same rounding).
+
+void RadiansAsShortString(char* res, double value, bool isDeflection);
+
+static const double DegToRad = (2.0 * 3.14159265358979323846) / 360.0;
+
+// A small random number generator, so that every run uses the same angles
+static unsigned int NextRandom(unsigned int& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed >> 8;
+}
+
+// The angle (in radians) for a number of degrees, minutes, and seconds
+static double GetRadians(int deg, int mins, double secs)
+{
+	return (deg + mins / 60.0 + secs / 3600.0) * DegToRad;
+}
+
+// Compares the two ways of formatting an angle, with and without the deflection flag,
+// and for the angle and its negation
+static void CheckRadians(double value)
+{
+	static unsigned int numReported = 0;
+
+	for (int i=0; i<4; i++)
+	{
+		double v = (i < 2 ? value : -value);
+		bool isDeflection = (i % 2 == 1);
+
+		char expected[64];
+		RadiansAsShortString(expected, v, isDeflection);
+
+		char result[NumberFormatter::MaxLength+1];
+		unsigned int len = NumberFormatter::FormatRadians(result, v, isDeflection);
+		result[len] = '\0';
+
+		bool isOk = (strcmp(result, expected) == 0 && len <= NumberFormatter::MaxLength);
+		if (!isOk && numReported++ < 10)
+			printf("FormatRadians(%.17g, %d) gave \"%s\", expected \"%s\"\n", v, (int)isDeflection, result, expected);
+
+		CHECK(isOk);
+	}
+}
+
+// Checks an angle, along with the angles up to n steps of the double either side of it
+static void CheckAround(double value, int n)
+{
+	double lo = value;
+	double hi = value;
+	CheckRadians(value);
+
+	for (int i=0; i<n; i++)
+	{
+		lo = nextafter(lo, -10.0);
+		hi = nextafter(hi, 10.0);
+		CheckRadians(lo);
+		CheckRadians(hi);
+	}
+}
+
+// Works out the seconds for an angle, the same way as FormatRadians
+static double GetSeconds(double value)
+{
+	double adeg = fabs(value * (360.0 / (2.0 * 3.14159265358979323846)));
+	double mins = (adeg - floor(adeg)) * 60.0;
+	return (mins - floor(mins)) * 60.0;
+}
+
+// True if FormatRadians would treat the seconds as lying on a half millisecond
+static bool IsHalfMillisecond(double value)
+{
+	double ms = GetSeconds(value) * 1000.0;
+	return (fabs(ms - floor(ms) - 0.5) < 1.0e-9);
+}
+
+void TestFormatRadians()
+{
+	// Whole seconds, plus the odd millisecond, for more than a full circle either way
+	for (__int64 ms = -400LL*3600000; ms <= 400LL*3600000; ms += 9973)
+	{
+		double deg = (double)ms / 3600000.0;
+		CheckAround(deg * DegToRad, 1);
+		CheckRadians(((double)ms + 0.5) / 3600000.0 * DegToRad);
+		CheckRadians(((double)ms + 0.9995) / 3600000.0 * DegToRad);
+	}
+
+	// Seconds that carry into the minutes (and minutes that carry into the degrees)
+	for (int deg=0; deg<400; deg += 7)
+	{
+		for (int mins=0; mins<60; mins++)
+		{
+			CheckAround(GetRadians(deg, mins, 59.999), 50);
+			CheckAround(GetRadians(deg, mins, 59.9995), 50);
+			for (double secs = 59.998; secs < 60.0; secs += 0.0000731)
+				CheckRadians(GetRadians(deg, mins, secs));
+		}
+	}
+
+	CheckAround(GetRadians(359, 59, 59.9999), 50);
+	CheckAround(GetRadians(0, 0, 60.0), 50);
+
+	// Seconds that are only just big enough to show
+	for (int deg=0; deg<360; deg += 11)
+	{
+		for (int mins=0; mins<60; mins += 3)
+		{
+			CheckAround(GetRadians(deg, mins, 0.001), 50);
+			CheckAround(GetRadians(deg, mins, 0.0005), 50);
+			CheckAround(GetRadians(deg, mins, 0.0009999), 10);
+		}
+	}
+
+	// Seconds on a half millisecond. Small angles have the most doubles close to each
+	// half millisecond, so some of them will land in the range where FormatRadians uses
+	// sprintf to round the seconds.
+	unsigned int numHalf = 0;
+
+	for (int mins=0; mins<3; mins++)
+	{
+		for (int ms=0; ms<60000; ms += 37)
+		{
+			double v = GetRadians(0, mins, (ms + 0.5) / 1000.0);
+			for (int i=0; i<100; i++)
+			{
+				CheckRadians(v);
+				if (IsHalfMillisecond(v))
+					numHalf++;
+
+				v = nextafter(v, 10.0);
+			}
+		}
+	}
+
+	CHECK(numHalf > 0);
+
+	// Random angles
+	unsigned int seed = 1;
+	for (int i=0; i<500000; i++)
+	{
+		double v = ((double)NextRandom(seed) / (double)(1 << 24) - 0.5) * 40.0;
+		CheckRadians(v);
+	}
+
+	// Zero (there's no such thing as -0-0)
+	CheckRadians(0.0);
+}
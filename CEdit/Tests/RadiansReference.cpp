@@ -0,0 +1,56 @@
+#include "StdAfx.h"
+#include <math.h>
+
+// The way EditSerializer used to write angles (before NumberFormatter::FormatRadians took
+// its place). It's kept here, unchanged, so the tests can check that the output is the same.
+void RadiansAsShortString(char* res, double value, bool isDeflection)
+{
+    // Convert to decimal degrees (possibly signed).
+    const double RADTODEG = 360.0 / (2.0 * 3.14159265358979323846);
+	double sdeg = value * RADTODEG;
+
+    // Get the degrees, minutes, and seconds, all unsigned.
+	double deg, mins, secs, rem;
+	double adeg = fabs(sdeg);
+    rem = modf(adeg, &deg);
+    rem = modf(rem*60.0, &mins);
+    secs = rem*60.0;
+
+    // Make sure we don't have max-values (i.e. 60's)
+	unsigned int ideg  = (unsigned int)(deg + 0.1);
+	unsigned int imins = (unsigned int)(mins + 0.1);
+
+	if (fabs(secs-60.0) < 0.001) // 3 decimals formatted below
+    {
+		secs -= 60.0;
+		secs = 0.0;
+		imins++;
+	}
+
+	if ( imins>=60 )
+    {
+		imins = 0;
+		ideg++;
+	}
+
+	// Normalize the degrees to be in the range [0,359]
+	while (ideg >= 360)
+		ideg -= 360;
+
+	// Create the return string, making sure that the sign is there.
+	if ( sdeg<0.0 )
+		sprintf(res, "-%d-%d", ideg, imins);
+	else
+		sprintf(res, "%d-%d", ideg, imins);
+
+	// Append seconds if they'll show.
+    if (secs>=0.001)
+	{
+		char extra[10];
+		sprintf(extra, "-%-.3f", secs);
+		strcat(res, extra);
+	}
+
+	if (isDeflection)
+		strcat(res, "d");
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Simple checks for the CEdit tests. A check that fails prints the file, line and
+// expression, and the test carries on (so one run shows every failure).
+
+void NoteCheck(bool isOk, LPCTSTR file, int line, LPCTSTR expr);
+
+#define CHECK(expr) NoteCheck((expr) ? true : false, __FILE__, __LINE__, #expr)
+
+// The tests (see TestMain.cpp for the names used to pick them on the command line)
+void TestLocationIndex();
+void TestFormatRadians();
+void TestLineStringCodec();
+void TestExportState();
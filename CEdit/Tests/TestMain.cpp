@@ -0,0 +1,90 @@
+#include "StdAfx.h"
+#include "Test.h"
+
+// Runs the CEdit tests. With no arguments, everything gets run, otherwise just the tests
+// named on the command line (e.g. "CEditTests location"). The exit code is the number
+// of checks that failed.
+
+struct UnitTest
+{
+	LPCTSTR Name;
+	void (*Run)();
+};
+
+static const UnitTest Tests[] =
+{
+	{ "location", TestLocationIndex },
+	{ "radians", TestFormatRadians },
+	{ "linestring", TestLineStringCodec },
+	{ "exportstate", TestExportState },
+};
+
+static const unsigned int NumTest = sizeof(Tests) / sizeof(Tests[0]);
+
+static unsigned int NumCheck = 0;
+static unsigned int NumFail = 0;
+
+// Only the first few failures at any one place get printed (checks are often made in loops)
+void NoteCheck(bool isOk, LPCTSTR file, int line, LPCTSTR expr)
+{
+	static LPCTSTR lastFile = 0;
+	static int lastLine = 0;
+	static unsigned int numRepeat = 0;
+
+	NumCheck++;
+	if (isOk)
+		return;
+
+	NumFail++;
+
+	if (file == lastFile && line == lastLine)
+		numRepeat++;
+	else
+		numRepeat = 0;
+
+	lastFile = file;
+	lastLine = line;
+
+	if (numRepeat < 5)
+		printf("%s(%d): check failed: %s\n", file, line, expr);
+	else if (numRepeat == 5)
+		printf("%s(%d): (further failures not shown)\n", file, line);
+}
+
+int main(int argc, char* argv[])
+{
+	if (!AfxWinInit(::GetModuleHandle(NULL), NULL, ::GetCommandLine(), 0))
+	{
+		printf("MFC failed to initialize\n");
+		return 1;
+	}
+
+	int nRun = 0;
+
+	for (unsigned int i=0; i<NumTest; i++)
+	{
+		bool run = (argc < 2);
+		for (int j=1; j<argc && !run; j++)
+			run = (_stricmp(argv[j], Tests[i].Name) == 0);
+
+		if (run)
+		{
+			unsigned int nFail = NumFail;
+			Tests[i].Run();
+			printf("%-20s %s\n", Tests[i].Name, (NumFail == nFail ? "ok" : "FAILED"));
+			nRun++;
+		}
+	}
+
+	if (nRun == 0)
+	{
+		printf("Unknown test. Choose from:");
+		for (unsigned int i=0; i<NumTest; i++)
+			printf(" %s", Tests[i].Name);
+		printf("\n");
+		return 1;
+	}
+
+	printf("%u checks, %u failed\n", NumCheck, NumFail);
+	return (int)NumFail;
+}
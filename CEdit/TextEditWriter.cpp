@@ -1,137 +1,244 @@
 #include "StdAfx.h"
+#include "NumberFormatter.h"
 #include "TextEditWriter.h"
 
 /// <summary>
 /// Writes an unsigned byte to a storage medium.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="value">The unsigned byte to write.</param>
-void TextEditWriter::WriteByte(LPCTSTR name, byte value)
+void TextEditWriter::WriteByte(DataField field, byte value)
 {
-	char buf[8];
-	sprintf(buf, "%d", value);
-    WriteValue(name, buf);
+	char* p = BeginValue(field, NumberFormatter::MaxLength);
+	p += NumberFormatter::FormatUInt32(p, value);
+	EndValue(p);
 }
 
 /// <summary>
 /// Writes a four-byte signed integer to a storage medium.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="value">The four-byte signed integer to write.</param>
-void TextEditWriter::WriteInt32(LPCTSTR name, int value)
+void TextEditWriter::WriteInt32(DataField field, int value)
 {
-	char buf[16];
-	sprintf(buf, "%d", value);
-    WriteValue(name, buf);
+	char* p = BeginValue(field, NumberFormatter::MaxLength);
+	p += NumberFormatter::FormatInt32(p, value);
+	EndValue(p);
 }
 
 /// <summary>
 /// Writes a four-byte unsigned integer to a storage medium.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="value">The four-byte unsigned integer to write.</param>
-void TextEditWriter::WriteUInt32(LPCTSTR name, unsigned int value)
+void TextEditWriter::WriteUInt32(DataField field, unsigned int value)
 {
-	char buf[16];
-	sprintf(buf, "%u", value);
-    WriteValue(name, buf);
+	char* p = BeginValue(field, NumberFormatter::MaxLength);
+	p += NumberFormatter::FormatUInt32(p, value);
+	EndValue(p);
 }
 
 /// <summary>
 /// Writes an eight-byte signed integer to a storage medium.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="value">The eight-byte signed integer to write.</param>
-void TextEditWriter::WriteInt64(LPCTSTR name, __int64 value)
+void TextEditWriter::WriteInt64(DataField field, __int64 value)
 {
-	char buf[32];
-	sprintf(buf, "%I64d", value);
-    WriteValue(name, buf);
+	char* p = BeginValue(field, NumberFormatter::MaxLength);
+	p += NumberFormatter::FormatInt64(p, value);
+	EndValue(p);
 }
 
 /// <summary>
 /// Writes an eight-byte floating-point value to a storage medium.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="value">The eight-byte floating-point value to write.</param>
-void TextEditWriter::WriteDouble(LPCTSTR name, double value)
+void TextEditWriter::WriteDouble(DataField field, double value)
 {
-	char buf[32];
-	sprintf(buf, "%f", value);
-    WriteValue(name, buf);
+	// Large values can need more than MaxLength characters (%f never uses an exponent)
+	char* p = BeginValue(field, 320);
+	p += NumberFormatter::FormatFixed6(p, value);
+	EndValue(p);
 }
 
 /// <summary>
 /// Writes an four-byte floating-point value to a storage medium.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="value">The four-byte floating-point value to write.</param>
-void TextEditWriter::WriteSingle(LPCTSTR name, float value)
+void TextEditWriter::WriteSingle(DataField field, float value)
 {
-	char buf[32];
-	sprintf(buf, "%f", value);
-    WriteValue(name, buf);
+	char* p = BeginValue(field, 320);
+	p += NumberFormatter::FormatFixed6(p, (double)value);
+	EndValue(p);
 }
 
 /// <summary>
 /// Writes a one-byte boolean value to a storage medium.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="value">The boolean value to write (0 or 1).</param>
-void TextEditWriter::WriteBool(LPCTSTR name, bool value)
+void TextEditWriter::WriteBool(DataField field, bool value)
 {
 	if (value)
-		WriteValue(name, "1");
+		WriteValue(field, "1");
 	else
-		WriteValue(name, "0");
+		WriteValue(field, "0");
 }
 
 /// <summary>
 /// Writes a string to a storage medium.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="value">The string to write (if a null is supplied, just the name tag will be written).</param>
-void TextEditWriter::WriteString(LPCTSTR name, LPCTSTR value)
+void TextEditWriter::WriteString(DataField field, LPCTSTR value)
 {
-    WriteValue(name, value);
+    WriteValue(field, value);
 }
 
 /// <summary>
 /// Writes a timestamp to a storage medium.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="when">The timestamp to write</param>
-void TextEditWriter::WriteDateTime(LPCTSTR name, const CTime& value)
+void TextEditWriter::WriteDateTime(DataField field, const CTime& value)
 {
-	WriteValue(name, (LPCTSTR)value.Format("%Y-%m-%dT%H:%M:%S"));
+	// Equivalent to value.Format("%Y-%m-%dT%H:%M:%S")
+	struct tm t;
+	value.GetLocalTm(&t);
+
+	char* p = BeginValue(field, NumberFormatter::MaxLength);
+	p += NumberFormatter::FormatInt32(p, t.tm_year + 1900);
+	*p++ = '-';
+	NumberFormatter::FormatTwoDigits(p, t.tm_mon + 1);
+	p[2] = '-';
+	NumberFormatter::FormatTwoDigits(p+3, t.tm_mday);
+	p[5] = 'T';
+	NumberFormatter::FormatTwoDigits(p+6, t.tm_hour);
+	p[8] = ':';
+	NumberFormatter::FormatTwoDigits(p+9, t.tm_min);
+	p[11] = ':';
+	NumberFormatter::FormatTwoDigits(p+12, t.tm_sec);
+	EndValue(p+14);
 }
 
 /// <summary>
 /// Writes an internal ID to a storage medium.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="id">The internal ID to write</param>
-void TextEditWriter::WriteInternalId(LPCTSTR name, unsigned int id)
+void TextEditWriter::WriteInternalId(DataField field, unsigned int id)
 {
-    WriteUInt32(name, id);
+    WriteUInt32(field, id);
+}
+
+/// <summary>
+/// Writes an array of bytes to a storage medium (in base64 form).
+/// </summary>
+/// <param name="field">The tag that identifies the item.</param>
+/// <param name="data">The bytes to write</param>
+/// <param name="length">The number of bytes to write</param>
+void TextEditWriter::WriteBytes(DataField field, const byte* data, unsigned int length)
+{
+	static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	char* p = BeginValue(field, ((length + 2) / 3) * 4);
+	unsigned int i = 0;
+
+	for (; i+2<length; i+=3)
+	{
+		unsigned int v = (data[i] << 16) | (data[i+1] << 8) | data[i+2];
+		p[0] = digits[v >> 18];
+		p[1] = digits[(v >> 12) & 0x3F];
+		p[2] = digits[(v >> 6) & 0x3F];
+		p[3] = digits[v & 0x3F];
+		p += 4;
+	}
+
+	// Pad out any partial group of 3 bytes
+	if (i < length)
+	{
+		unsigned int v = data[i] << 16;
+		if (i+1 < length)
+			v |= (data[i+1] << 8);
+
+		p[0] = digits[v >> 18];
+		p[1] = digits[(v >> 12) & 0x3F];
+		p[2] = (i+1 < length ? digits[(v >> 6) & 0x3F] : '=');
+		p[3] = '=';
+		p += 4;
+	}
+
+	EndValue(p);
 }
 
 /// <summary>
 /// Writes an object to text by calling its implementation of <see cref="System.Object.ToString"/>.
 /// </summary>
-/// <param name="name">A name tag for the item</param>
+/// <param name="field">The tag that identifies the item.</param>
 /// <param name="value">The object to write (if a null is supplied, just the name tag will be written).</param>
-void TextEditWriter::WriteValue(LPCTSTR name, LPCTSTR value)
+void TextEditWriter::WriteValue(DataField field, LPCTSTR value)
 {
     if (value == 0)
-		WriteLine(name);
+		WriteLine(DataFields[field]);
     else
 	{
-		WriteIndent();
-		fprintf(m_File, "%s=%s\n", name, value);
+		unsigned int len = (unsigned int)strlen(value);
+		char* p = BeginValue(field, len);
+		memcpy(p, value, len);
+		EndValue(p + len);
 	}
 }
 
+// Reserves space for the current indent, followed by "name=" and a value of up to
+// maxLength characters, returning a pointer to where the value should go. Once the value
+// has been written, call EndValue with a pointer to the end of it.
+char* TextEditWriter::BeginValue(DataField field, unsigned int maxLength)
+{
+	const DataFieldPrefix& prefix = DataFieldPrefixes[field];
+	return BeginValue(prefix.Text, prefix.Length, maxLength);
+}
+
+// As above, but for a "name=" prefix that has already been put together by the caller
+char* TextEditWriter::BeginValue(LPCTSTR prefix, unsigned int prefixLength, unsigned int maxLength)
+{
+	char* p = m_Output.Reserve(m_NumIndent + prefixLength + maxLength + 1);
+	m_ValueStart = p;
+
+	memset(p, '\t', m_NumIndent);
+	p += m_NumIndent;
+	memcpy(p, prefix, prefixLength);
+	return p + prefixLength;
+}
+
+// Terminates a value started with BeginValue
+void TextEditWriter::EndValue(char* end)
+{
+	*end++ = '\n';
+	m_Output.Commit((unsigned int)(end - m_ValueStart));
+}
+
+/// <summary>
+/// Writes the type name for an element in an array of objects (tagged with the array index).
+/// </summary>
+/// <param name="index">The array index of the element (0 for the first element)</param>
+/// <param name="typeName">The exported type name of the element.</param>
+void TextEditWriter::WriteArrayItem(unsigned int index, LPCTSTR typeName)
+{
+	char prefix[16];
+	prefix[0] = '[';
+	unsigned int len = 1 + NumberFormatter::FormatUInt32(prefix+1, index);
+	prefix[len++] = ']';
+	prefix[len++] = '=';
+
+	unsigned int typeLen = (unsigned int)strlen(typeName);
+	char* p = BeginValue(prefix, len, typeLen);
+	memcpy(p, typeName, typeLen);
+	EndValue(p + typeLen);
+}
+
 /// <summary>
 /// Writes the text that precedes the data values for an object.
 /// </summary>
@@ -162,13 +269,11 @@ void TextEditWriter::WriteLiteral(LPCTSTR val)
 // Writes text to the output, preceded by any indent, and followed by a newline
 void TextEditWriter::WriteLine(LPCTSTR line)
 {
-	WriteIndent();
-	fputs(line, m_File);
-	fputs("\n", m_File);
-}
+	unsigned int len = (unsigned int)strlen(line);
+	char* p = m_Output.Reserve(m_NumIndent + len + 1);
 
-void TextEditWriter::WriteIndent()
-{
-	for (int i=0; i<m_NumIndent; i++)
-		fputc('\t', m_File);
+	memset(p, '\t', m_NumIndent);
+	memcpy(p + m_NumIndent, line, len);
+	p[m_NumIndent + len] = '\n';
+	m_Output.Commit(m_NumIndent + len + 1);
 }
\ No newline at end of file
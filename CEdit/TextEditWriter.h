@@ -1,31 +1,40 @@
 #pragma once
-class TextEditWriter
+#include "IEditWriter.h"
+#include "OutputBuffer.h"
+
+// Writes edits as lines of the form "Name=value", as read by the TextEditReader class in Backsight.Editor
+class TextEditWriter : public IEditWriter
 {
 public:
-	TextEditWriter(FILE*& fp) : m_File(fp), m_NumIndent(0) {}
+	TextEditWriter(OutputBuffer& output) : m_Output(output), m_NumIndent(0) {}
 	virtual ~TextEditWriter(void) {}
 
 	void WriteBeginObject();
 	void WriteEndObject();
+	void WriteArrayItem(unsigned int index, LPCTSTR typeName);
 	void WriteLiteral(LPCTSTR value);
-	void WriteByte(LPCTSTR name, byte value);
-    void WriteInt32(LPCTSTR name, int value);
-    void WriteUInt32(LPCTSTR name, unsigned int value);
-    void WriteInt64(LPCTSTR name, __int64 value);
-    void WriteDouble(LPCTSTR name, double value);
-    void WriteSingle(LPCTSTR name, float value);
-    void WriteBool(LPCTSTR name, bool value);
-    void WriteString(LPCTSTR name, LPCTSTR value);
-    void WriteDateTime(LPCTSTR name, const CTime& value);
-    void WriteInternalId(LPCTSTR name, unsigned int id);
+	void WriteByte(DataField field, byte value);
+    void WriteInt32(DataField field, int value);
+    void WriteUInt32(DataField field, unsigned int value);
+    void WriteInt64(DataField field, __int64 value);
+    void WriteDouble(DataField field, double value);
+    void WriteSingle(DataField field, float value);
+    void WriteBool(DataField field, bool value);
+    void WriteString(DataField field, LPCTSTR value);
+    void WriteDateTime(DataField field, const CTime& value);
+    void WriteInternalId(DataField field, unsigned int id);
+    void WriteBytes(DataField field, const byte* data, unsigned int length);
 
 private:
-	void WriteValue(LPCTSTR name, LPCTSTR value);
-	void WriteIndent();
+	void WriteValue(DataField field, LPCTSTR value);
 	void WriteLine(LPCTSTR line);
+	char* BeginValue(DataField field, unsigned int maxLength);
+	char* BeginValue(LPCTSTR prefix, unsigned int prefixLength, unsigned int maxLength);
+	void EndValue(char* end);
 
 private:
-	FILE*& m_File;
+	OutputBuffer& m_Output;
 	int m_NumIndent;
+	char* m_ValueStart;
 };
 
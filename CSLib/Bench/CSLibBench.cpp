@@ -0,0 +1,117 @@
+using namespace System;
+using namespace System::Diagnostics;
+using namespace Backsight;
+using namespace CSLib;
+
+// Times the batch conversions in CoordinateSystem (GetGeographic, GetGrid, and
+// GetScaleFactors on arrays of values) against converting the same positions one
+// at a time, and checks that both ways give the same answers. Run it as
+//
+//   CSLibBench [<system key name> [<number of positions>]]
+//
+// The default is one million positions in UTM83-14. The CSMap dictionaries are
+// located through the CS_MAP_DIR environment variable.
+
+// Prints the time taken per position, in nanoseconds
+static void ReportTime(String^ name, int n, Stopwatch^ sw)
+{
+	double secs = sw->Elapsed.TotalSeconds;
+	Console::WriteLine("{0,-40} {1,10:F1} ns/position  ({2} positions in {3:F3} s)",
+		name, secs * 1.0e9 / (double)n, n, secs);
+}
+
+// Prints the biggest difference between two arrays of values
+static void ReportDifference(String^ name, array<double>^ a, array<double>^ b)
+{
+	double maxDiff = 0.0;
+	for (int i=0; i<a->Length; i++)
+		maxDiff = Math::Max(maxDiff, Math::Abs(a[i] - b[i]));
+
+	Console::WriteLine("{0,-40} {1:E3}", name, maxDiff);
+}
+
+int main(array<String^>^ args)
+{
+	String^ csKeyName = (args->Length > 0 ? args[0] : "UTM83-14");
+	int n = (args->Length > 1 ? Int32::Parse(args[1]) : 1000000);
+
+	CoordinateSystem^ cs = gcnew CoordinateSystem(csKeyName);
+	Console::WriteLine("{0}: {1} positions, {2} processors", csKeyName, n, Environment::ProcessorCount);
+
+	// Grid positions scattered over a 400km by 200km area near the middle of the zone
+	// (with the same random sequence every time)
+	array<double>^ xy = gcnew array<double>(2*n);
+	Random^ r = gcnew Random(1);
+	for (int i=0; i<n; i++)
+	{
+		xy[2*i] = 300000.0 + r->NextDouble() * 400000.0;
+		xy[2*i+1] = 5400000.0 + r->NextDouble() * 200000.0;
+	}
+
+	// Grid to geographic
+	array<double>^ one = gcnew array<double>(2*n);
+	Stopwatch^ sw = Stopwatch::StartNew();
+	for (int i=0; i<n; i++)
+	{
+		IPosition^ g = cs->GetGeographic(gcnew Position(xy[2*i], xy[2*i+1]));
+		one[2*i] = g->X;
+		one[2*i+1] = g->Y;
+	}
+	sw->Stop();
+	ReportTime("GetGeographic (one at a time)", n, sw);
+
+	array<double>^ lonlat = gcnew array<double>(2*n);
+	sw = Stopwatch::StartNew();
+	int nBad = cs->GetGeographic(xy, lonlat);
+	sw->Stop();
+	ReportTime("GetGeographic (batch)", n, sw);
+	ReportDifference("GetGeographic max difference (degrees)", one, lonlat);
+
+	if (nBad != 0)
+		Console::WriteLine("GetGeographic could not convert {0} positions", nBad);
+
+	// Geographic to grid. There's no method for a single position, so the one at a time
+	// figures come from batches of one.
+	array<double>^ ll1 = gcnew array<double>(2);
+	array<double>^ xy1 = gcnew array<double>(2);
+	sw = Stopwatch::StartNew();
+	for (int i=0; i<n; i++)
+	{
+		ll1[0] = lonlat[2*i];
+		ll1[1] = lonlat[2*i+1];
+		cs->GetGrid(ll1, xy1);
+		one[2*i] = xy1[0];
+		one[2*i+1] = xy1[1];
+	}
+	sw->Stop();
+	ReportTime("GetGrid (batches of one)", n, sw);
+
+	array<double>^ grid = gcnew array<double>(2*n);
+	sw = Stopwatch::StartNew();
+	nBad = cs->GetGrid(lonlat, grid);
+	sw->Stop();
+	ReportTime("GetGrid (batch)", n, sw);
+	ReportDifference("GetGrid max difference (meters)", one, grid);
+	ReportDifference("Round trip max difference (meters)", xy, grid);
+
+	if (nBad != 0)
+		Console::WriteLine("GetGrid could not convert {0} positions", nBad);
+
+	// Scale factors
+	array<double>^ sfac1 = gcnew array<double>(n);
+	sw = Stopwatch::StartNew();
+	for (int i=0; i<n; i++)
+		sfac1[i] = cs->GetScaleFactor(gcnew Position(xy[2*i], xy[2*i+1]));
+	sw->Stop();
+	ReportTime("GetScaleFactor (one at a time)", n, sw);
+
+	array<double>^ sfac = gcnew array<double>(n);
+	sw = Stopwatch::StartNew();
+	cs->GetScaleFactors(xy, sfac);
+	sw->Stop();
+	ReportTime("GetScaleFactors (batch)", n, sw);
+	ReportDifference("GetScaleFactors max difference", sfac1, sfac);
+
+	delete cs;
+	return 0;
+}
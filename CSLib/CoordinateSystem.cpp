@@ -1,6 +1,289 @@
+#include <windows.h>
+#include <process.h>
+#include <math.h>
+#include <string.h>
 #include "CoordinateSystem.h"
 #include "Chars.h"
 
+using namespace System::IO;
+using namespace System::Threading;
+using namespace System::Collections::Generic;
+
+// The loops that do batch conversions are compiled as native code, so there's
+// just one managed/native transition per batch (rather than one per position)
+#pragma managed(push, off)
+
+// Converts grid positions (x,y pairs) into geographic positions (longitude,latitude
+// pairs). Returns the number of positions that could not be converted cleanly.
+static int GridToGeographic(const cs_Csprm_* cs, const double* xy, double* ll, int n)
+{
+	double from[3];
+	double to[3];
+	from[2] = 0.0;
+	int nBad = 0;
+
+	for (int i=0; i<n; i++, xy+=2, ll+=2)
+	{
+		from[0] = xy[0];
+		from[1] = xy[1];
+		if (CS_cs2ll(cs, to, from) != 0)
+			nBad++;
+
+		ll[0] = to[0];
+		ll[1] = to[1];
+	}
+
+	return nBad;
+}
+
+// Converts geographic positions (longitude,latitude pairs) into grid positions (x,y
+// pairs). Returns the number of positions that could not be converted cleanly.
+static int GeographicToGrid(const cs_Csprm_* cs, const double* ll, double* xy, int n)
+{
+	double from[3];
+	double to[3];
+	from[2] = 0.0;
+	int nBad = 0;
+
+	for (int i=0; i<n; i++, ll+=2, xy+=2)
+	{
+		from[0] = ll[0];
+		from[1] = ll[1];
+		if (CS_ll2cs(cs, to, from) != 0)
+			nBad++;
+
+		xy[0] = to[0];
+		xy[1] = to[1];
+	}
+
+	return nBad;
+}
+
+// Obtains the grid scale factor at each of a series of grid positions (x,y pairs).
+// Returns the number of positions that could not be converted cleanly.
+static int GridScaleFactors(const cs_Csprm_* cs, const double* xy, double* sfac, int n)
+{
+	double from[3];
+	double ll[3];
+	from[2] = 0.0;
+	int nBad = 0;
+
+	for (int i=0; i<n; i++, xy+=2)
+	{
+		from[0] = xy[0];
+		from[1] = xy[1];
+		if (CS_cs2ll(cs, ll, from) != 0)
+			nBad++;
+
+		sfac[i] = CS_csscl(cs, ll);
+	}
+
+	return nBad;
+}
+
+// Obtains the grid scale factor at a single grid position
+static double GridScaleFactor(const cs_Csprm_* cs, const double* xy)
+{
+	double from[3];
+	double ll[3];
+	from[0] = xy[0];
+	from[1] = xy[1];
+	from[2] = 0.0;
+	CS_cs2ll(cs, ll, from);
+	return CS_csscl(cs, ll);
+}
+
+// Fills in the scale factors for the positions between start and end (exclusive), given
+// the scale factors at start and end. The position midway between them gets calculated,
+// and if it is within the tolerance of the value obtained by interpolating along the
+// shape (dist holds the cumulative distance to each position), the rest are interpolated.
+// Otherwise each half gets the same treatment.
+static void InterpolateScaleFactors(const cs_Csprm_* cs, const double* xy, const double* dist,
+									double* sfac, int start, int end, double tolerance)
+{
+	if (end - start < 2)
+		return;
+
+	int mid = (start + end) / 2;
+	sfac[mid] = GridScaleFactor(cs, xy + 2 * mid);
+
+	double len = dist[end] - dist[start];
+	double t = (len > 0.0 ? (dist[mid] - dist[start]) / len : 0.5);
+	double guess = sfac[start] + t * (sfac[end] - sfac[start]);
+
+	if (fabs(sfac[mid] - guess) > tolerance)
+	{
+		InterpolateScaleFactors(cs, xy, dist, sfac, start, mid, tolerance);
+		InterpolateScaleFactors(cs, xy, dist, sfac, mid, end, tolerance);
+		return;
+	}
+
+	// Interpolate each half separately (the midpoint value is known, so may as well use it)
+	for (int i=start+1; i<end; i++)
+	{
+		if (i == mid)
+			continue;
+
+		int s = (i < mid ? start : mid);
+		int e = (i < mid ? mid : end);
+		len = dist[e] - dist[s];
+		t = (len > 0.0 ? (dist[i] - dist[s]) / len : 0.5);
+		sfac[i] = sfac[s] + t * (sfac[e] - sfac[s]);
+	}
+}
+
+// Obtains scale factors for the n positions of a shape (x,y pairs), calculating them at
+// selected positions and interpolating the others (see InterpolateScaleFactors). The
+// work array must have space for n values.
+static void ApproximateScaleFactors(const cs_Csprm_* cs, const double* xy, double* sfac, int n,
+									double tolerance, double* work)
+{
+	double* dist = work;
+	dist[0] = 0.0;
+	for (int i=1; i<n; i++)
+	{
+		double dx = xy[2*i] - xy[2*i-2];
+		double dy = xy[2*i+1] - xy[2*i-1];
+		dist[i] = dist[i-1] + sqrt(dx*dx + dy*dy);
+	}
+
+	sfac[0] = GridScaleFactor(cs, xy);
+	sfac[n-1] = GridScaleFactor(cs, xy + 2 * (n-1));
+	InterpolateScaleFactors(cs, xy, dist, sfac, 0, n-1, tolerance);
+}
+
+// Works out the ground area of a closed shape with n positions (x,y pairs), given the
+// scale factor at each position, and the ellipsoid scale factor for the map. The work
+// array must have space for 2*n values.
+static double GroundArea(const double* xy, const double* sfac, int n, double efac, double* work)
+{
+	// Work with a local origin that corresponds to the first position (this DOES make
+	// quite a perceptible difference, especially when the area is fairly small). The
+	// first position is at the origin, so its scale factor isn't needed.
+	double* x = work;
+	double* y = work + n;
+	double xo = xy[0];
+	double yo = xy[1];
+	x[0] = 0.0;
+	y[0] = 0.0;
+
+	for (int i=1; i<n; i++)
+	{
+		double f = 1.0 / (sfac[i] * efac);
+		x[i] = (xy[2*i] - xo) * f;
+		y[i] = (xy[2*i+1] - yo) * f;
+	}
+
+	// Each segment contributes (ys-ye) * (xe+xs), which is double the (signed) area to the
+	// left of it. Accumulate 4 segments at a time, so the sums don't depend on each other.
+	double a0 = 0.0;
+	double a1 = 0.0;
+	double a2 = 0.0;
+	double a3 = 0.0;
+	int i = 1;
+
+	for (; i+3<n; i+=4)
+	{
+		a0 += (y[i-1] - y[i]) * (x[i] + x[i-1]);
+		a1 += (y[i] - y[i+1]) * (x[i+1] + x[i]);
+		a2 += (y[i+1] - y[i+2]) * (x[i+2] + x[i+1]);
+		a3 += (y[i+2] - y[i+3]) * (x[i+3] + x[i+2]);
+	}
+
+	for (; i<n; i++)
+		a0 += (y[i-1] - y[i]) * (x[i] + x[i-1]);
+
+	return ((a0 + a1) + (a2 + a3)) * 0.5;
+}
+
+// Batches smaller than this (per thread) aren't worth splitting up
+static const int MinPositionsPerThread = 4096;
+
+// Works out how many threads to use for a batch of n positions
+static int GetNumBatchThread(int n)
+{
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	int numThread = (int)si.dwNumberOfProcessors;
+
+	// The workers are waited on all at once
+	if (numThread > MAXIMUM_WAIT_OBJECTS)
+		numThread = MAXIMUM_WAIT_OBJECTS;
+
+	if (numThread > n / MinPositionsPerThread)
+		numThread = n / MinPositionsPerThread;
+
+	return (numThread < 1 ? 1 : numThread);
+}
+
+// The share of a batch conversion that gets done by one thread
+struct BatchSlice
+{
+	BatchConverter Convert;
+	const cs_Csprm_* Cs;
+	const double* From;
+	double* To;
+	int NumPosition;
+	int NumBad;
+};
+
+static unsigned __stdcall BatchSliceProc(void* arg)
+{
+	BatchSlice* s = (BatchSlice*)arg;
+	s->NumBad = s->Convert(s->Cs, s->From, s->To, s->NumPosition);
+	return 0;
+}
+
+// Splits a batch of n positions into one slice per thread (the positions all cost about
+// the same to convert, so the slices are the same size). Each input position is a pair of
+// values, and each output position has valuesPerOutput values. If a thread can't be
+// started, its slice gets converted on the calling thread instead. Returns the number of
+// positions that could not be converted cleanly.
+static int ParallelConvert(BatchConverter convert, cs_Csprm_** cs, int numThread,
+							const double* from, double* to, int valuesPerOutput, int n)
+{
+	BatchSlice slices[MAXIMUM_WAIT_OBJECTS];
+	HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+	int perThread = (n + numThread - 1) / numThread;
+	int numSlice = 0;
+	int numStarted = 0;
+
+	for (int t=0; t<numThread; t++)
+	{
+		int start = t * perThread;
+		if (start >= n)
+			break;
+
+		BatchSlice& s = slices[numSlice++];
+		s.Convert = convert;
+		s.Cs = cs[t];
+		s.From = from + 2 * start;
+		s.To = to + valuesPerOutput * start;
+		s.NumPosition = (n - start < perThread ? n - start : perThread);
+		s.NumBad = 0;
+
+		HANDLE h = (HANDLE)_beginthreadex(0, 0, BatchSliceProc, &s, 0, 0);
+		if (h == 0)
+			BatchSliceProc(&s);
+		else
+			threads[numStarted++] = h;
+	}
+
+	if (numStarted > 0)
+		WaitForMultipleObjects(numStarted, threads, TRUE, INFINITE);
+
+	for (int t=0; t<numStarted; t++)
+		CloseHandle(threads[t]);
+
+	int nBad = 0;
+	for (int t=0; t<numSlice; t++)
+		nBad += slices[t].NumBad;
+
+	return nBad;
+}
+
+#pragma managed(pop)
+
 namespace CSLib
 {
 
@@ -20,7 +303,17 @@ namespace CSLib
 		s_CsFolder = folder;
 	}
 
-	CoordinateSystem::CoordinateSystem(String^ csKeyName)
+	// static
+	CoordinateSystem::CoordinateSystem()
+	{
+		s_WktCache = nullptr;
+		s_WktLock = gcnew Object();
+	}
+
+	// Makes sure the folder containing the CSMap dictionaries has been defined (falling
+	// back on the CS_MAP_DIR environment variable)
+	// static
+	void CoordinateSystem::CheckHome()
 	{
 		if (String::IsNullOrEmpty(s_CsFolder))
 		{
@@ -28,29 +321,154 @@ namespace CSLib
 			if (String::IsNullOrEmpty(home))
 				throw gcnew Exception("CoordinateSystem.Home property has not been defined");
 
-			this->Home = home;
+			Home = home;
 		}
+	}
+
+	CoordinateSystem::CoordinateSystem(String^ csKeyName)
+	{
+		CheckHome();
 
 		m_CsData = CS_csloc(Chars::Convert(csKeyName));
 
 		if (m_CsData == nullptr)
 			throw gcnew Exception("Cannot locate coordinate system: "+csKeyName);
+
+		m_ThreadParams = nullptr;
+		m_NumThreadParams = 0;
 	}
 
 	CoordinateSystem::~CoordinateSystem()
 	{
+		// Copies of the parameters come after the first one (which is m_CsData)
+		for (int i=1; i<m_NumThreadParams; i++)
+		{
+			if (m_ThreadParams[i] != m_CsData)
+				CS_free(m_ThreadParams[i]);
+		}
+
+		delete [] m_ThreadParams;
 		CS_free(m_CsData);
 	}
 
 	double CoordinateSystem::GetScaleFactor(IPosition^ p)
 	{
-		IPosition^ ll = GetGeographic(p);
+		// Go straight to CSMap (GetGeographic would allocate a Position we don't need)
+		double xy[3];
+		xy[0] = p->X;
+		xy[1] = p->Y;
+		xy[2] = 0.0;
 		double latlon[3];
-		latlon[0] = ll->X;
-		latlon[1] = ll->Y;
+		CS_cs2ll(m_CsData, latlon, xy);
 		return CS_csscl(m_CsData, latlon);
 	}
 
+	// static
+	int CoordinateSystem::GetNumPosition(array<double>^ from, array<double>^ to, int valuesPerPosition)
+	{
+		if (from == nullptr || to == nullptr)
+			throw gcnew ArgumentNullException();
+
+		if ((from->Length % 2) != 0)
+			throw gcnew ArgumentException("Positions must be supplied as pairs of values");
+
+		int n = from->Length / 2;
+		if (to->Length < n * valuesPerPosition)
+			throw gcnew ArgumentException("Output array is too small");
+
+		return n;
+	}
+
+	int CoordinateSystem::GetGeographic(array<double>^ xy, array<double>^ lonlat)
+	{
+		int n = GetNumPosition(xy, lonlat, 2);
+		if (n == 0)
+			return 0;
+
+		pin_ptr<double> pxy = &xy[0];
+		pin_ptr<double> pll = &lonlat[0];
+		return RunBatch(GridToGeographic, pxy, pll, 2, n);
+	}
+
+	int CoordinateSystem::GetGrid(array<double>^ lonlat, array<double>^ xy)
+	{
+		int n = GetNumPosition(lonlat, xy, 2);
+		if (n == 0)
+			return 0;
+
+		pin_ptr<double> pll = &lonlat[0];
+		pin_ptr<double> pxy = &xy[0];
+		return RunBatch(GeographicToGrid, pll, pxy, 2, n);
+	}
+
+	void CoordinateSystem::GetScaleFactors(array<double>^ xy, array<double>^ sfac)
+	{
+		int n = GetNumPosition(xy, sfac, 1);
+		if (n == 0)
+			return;
+
+		pin_ptr<double> pxy = &xy[0];
+		pin_ptr<double> psf = &sfac[0];
+		RunBatch(GridScaleFactors, pxy, psf, 1, n);
+	}
+
+	// Converts a batch of positions, using several threads if the batch is big enough
+	int CoordinateSystem::RunBatch(BatchConverter convert, const double* from, double* to, int valuesPerOutput, int n)
+	{
+		int numThread = GetNumBatchThread(n);
+		if (numThread > 1)
+			numThread = GetThreadParams(numThread);
+
+		if (numThread <= 1)
+			return convert(m_CsData, from, to, n);
+
+		return ParallelConvert(convert, m_ThreadParams, numThread, from, to, valuesPerOutput, n);
+	}
+
+	// Ensures there are conversion parameters for the specified number of threads. If the
+	// projection code isn't reentrant, each thread gets a copy of its own (obtained from
+	// the coordinate system dictionary). Returns the number of threads that can be used
+	// (less than requested if the dictionary couldn't supply enough copies).
+	int CoordinateSystem::GetThreadParams(int numThread)
+	{
+		if (numThread > m_NumThreadParams)
+		{
+			cs_Csprm_** params = new cs_Csprm_*[numThread];
+			params[0] = m_CsData;
+			int nDone = 1;
+
+			for (int i=1; i<m_NumThreadParams; i++)
+				params[nDone++] = m_ThreadParams[i];
+
+			bool isReentrant = (CS_isCsPrmReentrant(m_CsData) != 0);
+			for (; nDone<numThread; nDone++)
+			{
+				cs_Csprm_* cs = (isReentrant ? m_CsData : CS_csloc(m_CsData->csdef.key_nm));
+				if (cs == nullptr)
+					break;
+
+				params[nDone] = cs;
+			}
+
+			delete [] m_ThreadParams;
+			m_ThreadParams = params;
+			m_NumThreadParams = nDone;
+		}
+
+		// The geoid separation and mean elevation may have been changed since a copy was made
+		for (int i=1; i<m_NumThreadParams; i++)
+		{
+			cs_Csprm_* cs = m_ThreadParams[i];
+			if (cs != m_CsData)
+			{
+				cs->csdef.geoid_sep = m_CsData->csdef.geoid_sep;
+				cs->csdef.hgt_zz = m_CsData->csdef.hgt_zz;
+			}
+		}
+
+		return (numThread < m_NumThreadParams ? numThread : m_NumThreadParams);
+	}
+
 	IPosition^ CoordinateSystem::GetGeographic(IPosition^ p)
 	{
 		double xy[3];
@@ -73,62 +491,52 @@ namespace CSLib
         if (v->Length <= 2)
             return 0.0;
 
-		double a = this->EquitorialRadius;
-		double b = this->PolarRadius;
-
-        // Get the ellipsoid scale factor for the map (note that
-        // geoid separation is expected to be a positive value in
-        // places where the geoid is above the reference ellipsoid).
-		double efac = a / (a + this->MeanElevation->Meters + this->GeoidSeparation->Meters);
-
-        // Get the eccentricity
-        //double asq = a*a;
-        //double esq = (asq - b*b)/(asq);
-
-        // Actually, the documentation says you should divide by b*b,
-        // not that it should make much difference
-		double bsq = b*b;
-        double esq = (a*a - bsq)/(bsq);
-
-        // Work with a local origin the corresponds to the first
-        // position (this DOES make quite a perceptible difference,
-        // especially when the area is fairly small).
+		array<double>^ xy = gcnew array<double>(2 * v->Length);
+		for (int i=0, j=0; i<v->Length; i++, j+=2)
+		{
+			xy[j] = v[i]->X;
+			xy[j+1] = v[i]->Y;
+		}
 
-        double xo = v[0]->X;
-        double yo = v[0]->Y;
+		return GetGroundArea(xy, 0.0);
+	}
 
-        // The initial position is at the local origin (the
-        // multiplying factor won't be used)
+	double CoordinateSystem::GetGroundArea(array<double>^ xy)
+	{
+		return GetGroundArea(xy, 0.0);
+	}
 
-        double xs = 0.0;
-        double ys = 0.0;
-        double f1 = 0.0;
+	double CoordinateSystem::GetGroundArea(array<double>^ xy, double sfacTolerance)
+	{
+		if (xy == nullptr)
+			throw gcnew ArgumentNullException();
 
-        double f2;
-        double xe;
-        double ye;
+		if ((xy->Length % 2) != 0)
+			throw gcnew ArgumentException("Positions must be supplied as pairs of values");
 
-        double area = 0.0;
+		int n = xy->Length / 2;
+		if (n <= 2)
+			return 0.0;
 
-        for ( int i=1; i<v->Length; i++, f1=f2, xs=xe, ys=ye )
-        {
-            // Get the scale factor at the end of the current segment
-            f2 = 1.0 / (GetScaleFactor(v[i]) * efac);
-            xe = (v[i]->X - xo) * f2;
-            ye = (v[i]->Y - yo) * f2;
+		// Scale factors, followed by space for the kernels to work in
+		array<double>^ sfac = gcnew array<double>(3 * n);
+		pin_ptr<double> pxy = &xy[0];
+		pin_ptr<double> psf = &sfac[0];
 
-            // Use the mid-X of the segment to get the area left (signed).
-            // If the line is directed up the way, it contributes a
-            // positive area. If directed down, it contributes a
-            // negative area. So, if flat, it contributes nothing (what
-            // we are actually calculating here is double the area; we
-            // will adjust this when we are done with the loop).
+		if (sfacTolerance > 0.0)
+			ApproximateScaleFactors(m_CsData, pxy, psf, n, sfacTolerance, psf + n);
+		else
+			RunBatch(GridScaleFactors, pxy, psf, 1, n);
 
-            double extra = (ys-ye) * (xe+xs);
-            area += extra;
-        }
+		return GroundArea(pxy, psf, n, GetEllipsoidFactor(), psf + n);
+	}
 
-        return (area * 0.5);
+	// Gets the ellipsoid scale factor for the map (note that geoid separation is expected
+	// to be a positive value in places where the geoid is above the reference ellipsoid).
+	double CoordinateSystem::GetEllipsoidFactor()
+	{
+		double a = this->EquitorialRadius;
+		return a / (a + m_CsData->csdef.hgt_zz + m_CsData->csdef.geoid_sep);
 	}
 
 	// The structure doesn't provide the expected values, but WKT does
@@ -141,10 +549,165 @@ namespace CSLib
 	//}
 
 	String^ CoordinateSystem::GetWellKnownText()
-	{		
-		// Takes a surprising time (8.9 seconds) on first call (0.1 seconds thereafter).
-		char buf [512];
-		CS_cs2Wkt(buf, sizeof(buf), m_CsData->csdef.key_nm, 0);
-		return Chars::Convert(buf);
+	{
+		return GetWellKnownText(0);
+	}
+
+	String^ CoordinateSystem::GetWellKnownText(int flavor)
+	{
+		return FindWellKnownText(Chars::Convert(m_CsData->csdef.key_nm), flavor);
+	}
+
+	// static
+	void CoordinateSystem::BeginWellKnownTextWarmUp(String^ csKeyName)
+	{
+		CheckHome();
+
+		Thread^ t = gcnew Thread(gcnew ParameterizedThreadStart(&CoordinateSystem::WellKnownTextWarmUp));
+		t->IsBackground = true;
+		t->Start(csKeyName);
+	}
+
+	// static
+	void CoordinateSystem::WellKnownTextWarmUp(Object^ csKeyName)
+	{
+		// Nobody is waiting on this, so anything that goes wrong will show up again
+		// when the WKT is actually asked for
+		try
+		{
+			FindWellKnownText((String^)csKeyName, 0);
+		}
+		catch (Exception^)
+		{
+		}
+	}
+
+	// Obtains the WKT for a system, from the cache if it's already known
+	// static
+	String^ CoordinateSystem::FindWellKnownText(String^ csKeyName, int flavor)
+	{
+		String^ key = csKeyName + "\t" + flavor;
+
+		Monitor::Enter(s_WktLock);
+
+		try
+		{
+			if (s_WktCache == nullptr)
+				LoadWktCache();
+
+			String^ wkt;
+			if (s_WktCache->TryGetValue(key, wkt))
+				return wkt;
+
+			wkt = MakeWellKnownText(csKeyName, flavor);
+			if (wkt->Length > 0)
+			{
+				s_WktCache[key] = wkt;
+				SaveWktCache();
+			}
+
+			return wkt;
+		}
+		finally
+		{
+			Monitor::Exit(s_WktLock);
+		}
+	}
+
+	// Asks CSMap for the WKT of a system (an empty string if it can't be produced)
+	// static
+	String^ CoordinateSystem::MakeWellKnownText(String^ csKeyName, int flavor)
+	{
+		// Takes a surprising time (8.9 seconds) on first call (0.1 seconds thereafter),
+		// which seems to be spent loading the name mapper.
+		char* keyName = Chars::Convert(csKeyName);
+
+		// The WKT gets truncated if it doesn't fit, so try a bigger buffer if it got filled
+		for (size_t size=1024; size<=65536; size*=4)
+		{
+			char* buf = new char[size];
+			buf[0] = '\0';
+			int res = CS_cs2Wkt(buf, size, keyName, flavor);
+			size_t len = strlen(buf);
+			String^ wkt = (res < 0 ? String::Empty : Chars::Convert(buf));
+			delete [] buf;
+
+			if (res < 0 || len < size-1)
+				return wkt;
+		}
+
+		return String::Empty;
+	}
+
+	// Identifies the versions of the dictionaries that WKT depends on (so that the cache
+	// can be ignored if they've changed). The WKT for a system includes its datum and
+	// ellipsoid, so those dictionaries count as well as the system dictionary.
+	// static
+	String^ CoordinateSystem::GetWktCacheStamp()
+	{
+		DateTime csTime = File::GetLastWriteTimeUtc(Path::Combine(s_CsFolder, cs_CS_NAME));
+		DateTime dtTime = File::GetLastWriteTimeUtc(Path::Combine(s_CsFolder, cs_DAT_NAME));
+		DateTime elTime = File::GetLastWriteTimeUtc(Path::Combine(s_CsFolder, cs_ELL_NAME));
+		DateTime nmTime = File::GetLastWriteTimeUtc(Path::Combine(s_CsFolder, cs_NMP_NAME));
+		return String::Format("CSLib WKT 2 {0} {1} {2} {3}", csTime.Ticks, dtTime.Ticks, elTime.Ticks, nmTime.Ticks);
+	}
+
+	// Loads the WKT saved by earlier sessions. The cache is just an optimization, so if it
+	// can't be read (or is out of date), we start out with nothing.
+	// static
+	void CoordinateSystem::LoadWktCache()
+	{
+		s_WktCache = gcnew Dictionary<String^, String^>();
+
+		try
+		{
+			String^ fileName = Path::Combine(s_CsFolder, "Wkt.cache");
+			if (!File::Exists(fileName))
+				return;
+
+			array<String^>^ lines = File::ReadAllLines(fileName);
+			if (lines->Length == 0 || lines[0] != GetWktCacheStamp())
+				return;
+
+			// Each line is <key name><tab><flavor><tab><wkt>
+			for (int i=1; i<lines->Length; i++)
+			{
+				String^ s = lines[i];
+				int tab = s->IndexOf('\t');
+				int wktStart = (tab < 0 ? -1 : s->IndexOf('\t', tab+1) + 1);
+
+				if (wktStart > 0)
+					s_WktCache[s->Substring(0, wktStart-1)] = s->Substring(wktStart);
+			}
+		}
+		catch (Exception^)
+		{
+			s_WktCache->Clear();
+		}
+	}
+
+	// Rewrites the WKT cache file (there's only ever a handful of entries)
+	// static
+	void CoordinateSystem::SaveWktCache()
+	{
+		try
+		{
+			List<String^>^ lines = gcnew List<String^>(s_WktCache->Count + 1);
+			lines->Add(GetWktCacheStamp());
+
+			for each (KeyValuePair<String^, String^> e in s_WktCache)
+			{
+				// Anything that would mess up the line structure just isn't saved
+				if (e.Value->IndexOfAny(gcnew array<wchar_t> { '\r', '\n' }) < 0)
+					lines->Add(e.Key + "\t" + e.Value);
+			}
+
+			File::WriteAllLines(Path::Combine(s_CsFolder, "Wkt.cache"), lines->ToArray());
+		}
+		catch (Exception^)
+		{
+			// The dictionary folder may well be read-only, in which case we just do
+			// without a cache file
+		}
 	}
 }
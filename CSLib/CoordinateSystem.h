@@ -6,6 +6,10 @@
 using namespace System;
 using namespace Backsight;
 
+// A native loop that converts n positions (see CoordinateSystem.cpp). Returns the number
+// of positions that could not be converted cleanly.
+typedef int (*BatchConverter)(const cs_Csprm_* cs, const double* from, double* to, int n);
+
 namespace CSLib
 {
 	public ref class CoordinateSystem : public ISpatialSystem
@@ -13,9 +17,35 @@ namespace CSLib
 	public:
 		CoordinateSystem(String^ csKeyName);
 		~CoordinateSystem();
+		static CoordinateSystem();
 
 		double GetScaleFactor(IPosition^ p);
 
+		/*
+		** Batch conversions. Positions are held as consecutive pairs of values
+		** (x,y for grid positions, longitude,latitude in degrees for geographic
+		** positions), and the output arrays must be at least as big as needed.
+		** The conversions are done in a native loop, with nothing allocated per
+		** position. Big batches get split across one thread per processor. If
+		** the projection code isn't reentrant, each extra thread works with its
+		** own copy of the coordinate system parameters. GetGeographic and GetGrid
+		** return the number of positions that CSMap could not convert cleanly
+		** (0 if all is well).
+		*/
+		int GetGeographic(array<double>^ xy, array<double>^ lonlat);
+		int GetGrid(array<double>^ lonlat, array<double>^ xy);
+		void GetScaleFactors(array<double>^ xy, array<double>^ sfac);
+
+		/*
+		** The ground area of a closed shape whose positions are held as x,y pairs.
+		** With a tolerance greater than zero, scale factors are only worked out
+		** at selected positions, and interpolated (by distance along the shape)
+		** for the positions in between, wherever interpolation gets within the
+		** tolerance of the actual scale factor.
+		*/
+		double GetGroundArea(array<double>^ xy);
+		double GetGroundArea(array<double>^ xy, double sfacTolerance);
+
 		/* Implement ISpatialSystem */
 
 		/* why virtual, __clrcall, sealed? - see 
@@ -27,6 +57,21 @@ namespace CSLib
         virtual double __clrcall GetGroundArea(array<IPosition^>^ closedShape) sealed;
 		virtual String^ __clrcall GetWellKnownText() sealed;
 
+		/*
+		** The WKT for the system in a specific flavor (one of the ErcWktFlavor
+		** values in cs_map.h). WKT is remembered once produced, and saved in a
+		** file in the Home folder, so that later sessions can skip CSMap.
+		*/
+		String^ GetWellKnownText(int flavor);
+
+		/*
+		** Starts a background thread that obtains the WKT for a system. CSMap
+		** takes several seconds to produce WKT the first time it's asked, so
+		** calling this at startup means the delay is usually over by the time
+		** the WKT is actually needed.
+		*/
+		static void BeginWellKnownTextWarmUp(String^ csKeyName);
+
 		virtual property ILength^ GeoidSeparation
 		{
 			ILength^ __clrcall get() sealed
@@ -92,6 +137,18 @@ namespace CSLib
 
 	private:
 
+		static void CheckHome();
+		static String^ FindWellKnownText(String^ csKeyName, int flavor);
+		static String^ MakeWellKnownText(String^ csKeyName, int flavor);
+		static void WellKnownTextWarmUp(Object^ csKeyName);
+		static void LoadWktCache();
+		static void SaveWktCache();
+		static String^ GetWktCacheStamp();
+		static int GetNumPosition(array<double>^ from, array<double>^ to, int valuesPerPosition);
+		int RunBatch(BatchConverter convert, const double* from, double* to, int valuesPerOutput, int n);
+		int GetThreadParams(int numThread);
+		double GetEllipsoidFactor();
+
 		/* The equatorial radius, in meters */
 		property double EquitorialRadius
 		{
@@ -106,6 +163,22 @@ namespace CSLib
 
 		cs_Csprm_* m_CsData;
 
+		// The parameters used by each thread in a batch conversion (the first
+		// is always m_CsData; the rest are either m_CsData too, or copies of
+		// it that are made the first time they're needed)
+		cs_Csprm_** m_ThreadParams;
+
+		// The number of entries in m_ThreadParams
+		int m_NumThreadParams;
+
 		static String^ s_CsFolder;
+
+		// WKT obtained so far, keyed by "<system key name><tab><flavor>" (null
+		// until the cache file has been read)
+		static System::Collections::Generic::Dictionary<String^, String^>^ s_WktCache;
+
+		// Locked while WKT is looked up or produced (CSMap can't be trusted to
+		// produce WKT on more than one thread at a time)
+		static Object^ s_WktLock;
 	};
 }
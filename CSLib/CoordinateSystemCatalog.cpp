@@ -23,41 +23,99 @@ namespace CSLib
 		if (res!=0)
 			throw gcnew Exception("Cannot locate coordinate system data folder");
 
+		// Datums and ellipsoids get indexed as they're read, so that systems can refer to them
 		this->Datums = ReadDatums();
 		this->Ellipsoids = ReadEllipsoids();
 		this->Systems = ReadSystems();
+		IndexSystems();
 		this->Categories = ReadCategories();
 	}
 
-	CoordinateSystemDef^ CoordinateSystemCatalog::FindByEPSGNumber(short epsgNumber)
+	void CoordinateSystemCatalog::IndexSystems()
 	{
+		m_SystemsByEPSG = gcnew Dictionary<short, CoordinateSystemDef^>(this->Systems->Length);
+		m_SystemsByKey = gcnew Dictionary<String^, CoordinateSystemDef^>(this->Systems->Length);
+		m_SystemsByGroup = gcnew Dictionary<String^, List<CoordinateSystemDef^>^>();
+		m_SystemsByLocation = gcnew Dictionary<String^, List<CoordinateSystemDef^>^>();
+
 		for each (CoordinateSystemDef^ cs in this->Systems)
 		{
-			if (cs->EPSGNumber == epsgNumber)
-				return cs;
+			if (!m_SystemsByEPSG->ContainsKey(cs->EPSGNumber))
+				m_SystemsByEPSG->Add(cs->EPSGNumber, cs);
+
+			if (!m_SystemsByKey->ContainsKey(cs->KeyName))
+				m_SystemsByKey->Add(cs->KeyName, cs);
+
+			AddToIndex(m_SystemsByGroup, cs->Group, cs);
+			AddToIndex(m_SystemsByLocation, cs->Location, cs);
+		}
+	}
+
+	// static
+	void CoordinateSystemCatalog::AddToIndex(Dictionary<String^, List<CoordinateSystemDef^>^>^ index, String^ key, CoordinateSystemDef^ cs)
+	{
+		List<CoordinateSystemDef^>^ systems;
+		if (!index->TryGetValue(key, systems))
+		{
+			systems = gcnew List<CoordinateSystemDef^>();
+			index->Add(key, systems);
 		}
 
+		systems->Add(cs);
+	}
+
+	// static
+	array<CoordinateSystemDef^>^ CoordinateSystemCatalog::FindInIndex(Dictionary<String^, List<CoordinateSystemDef^>^>^ index, String^ key)
+	{
+		List<CoordinateSystemDef^>^ systems;
+		if (key != nullptr && index->TryGetValue(key, systems))
+			return systems->ToArray();
+
+		return gcnew array<CoordinateSystemDef^>(0);
+	}
+
+	CoordinateSystemDef^ CoordinateSystemCatalog::FindByEPSGNumber(short epsgNumber)
+	{
+		CoordinateSystemDef^ cs;
+		if (m_SystemsByEPSG->TryGetValue(epsgNumber, cs))
+			return cs;
+
 		return nullptr;
 	}
 
+	CoordinateSystemDef^ CoordinateSystemCatalog::FindByKeyName(String^ keyName)
+	{
+		CoordinateSystemDef^ cs;
+		if (keyName != nullptr && m_SystemsByKey->TryGetValue(keyName, cs))
+			return cs;
+
+		return nullptr;
+	}
+
+	array<CoordinateSystemDef^>^ CoordinateSystemCatalog::FindByGroup(String^ group)
+	{
+		return FindInIndex(m_SystemsByGroup, group);
+	}
+
+	array<CoordinateSystemDef^>^ CoordinateSystemCatalog::FindByLocation(String^ location)
+	{
+		return FindInIndex(m_SystemsByLocation, location);
+	}
+
 	DatumDef^ CoordinateSystemCatalog::FindDatumByKeyName(String^ keyName)
 	{
-		for each (DatumDef^ datum in this->Datums)
-		{
-			if (datum->KeyName == keyName)
-				return datum;
-		}
+		DatumDef^ datum;
+		if (keyName != nullptr && m_DatumsByKey->TryGetValue(keyName, datum))
+			return datum;
 
 		return nullptr;
 	}
 
 	EllipsoidDef^ CoordinateSystemCatalog::FindEllipsoidByKeyName(String^ keyName)
 	{
-		for each (EllipsoidDef^ e in this->Ellipsoids)
-		{
-			if (e->KeyName == keyName)
-				return e;
-		}
+		EllipsoidDef^ e;
+		if (keyName != nullptr && m_EllipsoidsByKey->TryGetValue(keyName, e))
+			return e;
 
 		return nullptr;
 	}
@@ -138,9 +196,13 @@ namespace CSLib
 			csDef->EPSGNumber = cs.epsgNbr;
 			csDef->WKTFlavor = cs.wktFlvr;
 
-			// Provide expanded versions of important fields
-			//csDef->Datum = FindDatumByKeyName(csDef->DatumKeyName);
-			//csDef->Ellipsoid = FindEllipsoidByKeyName(csDef->EllipsoidKeyName);
+			// Provide expanded versions of important fields (systems that are based on a
+			// datum don't name an ellipsoid, so get it from the datum)
+			csDef->Datum = FindDatumByKeyName(csDef->DatumKeyName);
+			if (csDef->Datum != nullptr && String::IsNullOrEmpty(csDef->EllipsoidKeyName))
+				csDef->Ellipsoid = FindEllipsoidByKeyName(csDef->Datum->EllipsoidKeyName);
+			else
+				csDef->Ellipsoid = FindEllipsoidByKeyName(csDef->EllipsoidKeyName);
 
 			csDefs->Add(csDef);
 		}
@@ -156,6 +218,7 @@ namespace CSLib
 		cs_Dtdef_ datum;
 		FILE* datumFile = CS_dtopn("rb");
 		List<DatumDef^>^ datums = gcnew List<DatumDef^>();
+		m_DatumsByKey = gcnew Dictionary<String^, DatumDef^>();
 
 		while ((res = CS_dtrd (datumFile,&datum,&crypt)) > 0)
 		{
@@ -181,6 +244,8 @@ namespace CSLib
 			dd->WKTFlavor = datum.wktFlvr;
 
 			datums->Add(dd);
+			if (!m_DatumsByKey->ContainsKey(dd->KeyName))
+				m_DatumsByKey->Add(dd->KeyName, dd);
 		}
 
 		CS_dtDictCls (datumFile);
@@ -194,6 +259,7 @@ namespace CSLib
 		cs_Eldef_ ellipsoid;
 		FILE* elFile = CS_elopn("rb");
 		List<EllipsoidDef^>^ elps = gcnew List<EllipsoidDef^>();
+		m_EllipsoidsByKey = gcnew Dictionary<String^, EllipsoidDef^>();
 
 		while ((res = CS_elrd (elFile,&ellipsoid,&crypt)) > 0)
 		{
@@ -212,6 +278,8 @@ namespace CSLib
 			elp->WKTFlavor = ellipsoid.wktFlvr;
 
 			elps->Add(elp);
+			if (!m_EllipsoidsByKey->ContainsKey(elp->KeyName))
+				m_EllipsoidsByKey->Add(elp->KeyName, elp);
 		}
 
 		CS_elDictCls (elFile);
@@ -221,11 +289,6 @@ namespace CSLib
 
 	array<CategoryDef^>^ CoordinateSystemCatalog::ReadCategories()
 	{
-		// Index previously loaded systems
-		Dictionary<String^, CoordinateSystemDef^>^ csDic = gcnew Dictionary<String^, CoordinateSystemDef^>();
-		for each (CoordinateSystemDef^ cs in this->Systems)
-			csDic->Add(cs->KeyName, cs);
-
 		String^ catFile = Path::Combine(m_CSFolder, "category.asc");
 		StreamReader^ sr = File::OpenText(catFile);
 		String^ s;
@@ -259,7 +322,7 @@ namespace CSLib
 
 					// Some systems are included in the category list, but may not
 					// be in the coordinate system list (possibly for legal reasons).
-					if (csDic->TryGetValue(s, cs))
+					if (m_SystemsByKey->TryGetValue(s, cs))
 						catSystems->Add(cs);
 				}
 			}
@@ -6,6 +6,7 @@
 #include "CategoryDef.h"
 
 using namespace System;
+using namespace System::Collections::Generic;
 
 namespace CSLib
 {
@@ -24,6 +25,9 @@ namespace CSLib
 
 		void Load();
 		CoordinateSystemDef^ FindByEPSGNumber(short epsgNumber);
+		CoordinateSystemDef^ FindByKeyName(String^ keyName);
+		array<CoordinateSystemDef^>^ FindByGroup(String^ group);
+		array<CoordinateSystemDef^>^ FindByLocation(String^ location);
 
 	private:
 		array<DatumDef^>^ ReadDatums();
@@ -32,7 +36,19 @@ namespace CSLib
 		array<CategoryDef^>^ ReadCategories();
 		DatumDef^ FindDatumByKeyName(String^ keyName);
 		EllipsoidDef^ FindEllipsoidByKeyName(String^ keyName);
+		void IndexSystems();
+		static void AddToIndex(Dictionary<String^, List<CoordinateSystemDef^>^>^ index, String^ key, CoordinateSystemDef^ cs);
+		static array<CoordinateSystemDef^>^ FindInIndex(Dictionary<String^, List<CoordinateSystemDef^>^>^ index, String^ key);
 
 		String^ m_CSFolder;
+
+		// Indexes built by Load. Where more than one entry has the same EPSG number
+		// or key name, the index refers to the first one in the dictionary.
+		Dictionary<short, CoordinateSystemDef^>^ m_SystemsByEPSG;
+		Dictionary<String^, CoordinateSystemDef^>^ m_SystemsByKey;
+		Dictionary<String^, List<CoordinateSystemDef^>^>^ m_SystemsByGroup;
+		Dictionary<String^, List<CoordinateSystemDef^>^>^ m_SystemsByLocation;
+		Dictionary<String^, DatumDef^>^ m_DatumsByKey;
+		Dictionary<String^, EllipsoidDef^>^ m_EllipsoidsByKey;
 	};
 }
@@ -17,11 +17,15 @@ namespace CSLib
 
 		[Description("The key name of the datum upon which the coordinate system is based.")]
 		property String^ DatumKeyName; // dat_knm [24]		
-		//property DatumDef^ Datum;
+
+		[Description("The datum upon which the coordinate system is based (if any).")]
+		property DatumDef^ Datum;
 
 		[Description("The key name of the ellipsoid upon which the coordinate system is based.")]
 		property String^ EllipsoidKeyName; // elp_knm [24]
-		//property EllipsoidDef^ Ellipsoid;
+
+		[Description("The ellipsoid upon which the coordinate system (or its datum) is based.")]
+		property EllipsoidDef^ Ellipsoid;
 								   
 		[Description("The key name of the projection upon which the coordinate system is based.")]
 		property String^ ProjectionKeyName; // prj_knm [24]